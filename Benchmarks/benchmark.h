@@ -0,0 +1,64 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+/**
+ * Timing helpers shared by the benchmark suites.
+ * Every measurement is the median of several runs after one warm-up run, which keeps a stray context switch from skewing it.
+ */
+namespace bench {
+/**
+ * Calls func() runs times and returns the median wall time of one call, in nanoseconds.
+ * @param func
+ * @param runs
+ * @return
+ */
+template <typename Func>
+double median(Func func, int runs = 9)
+{
+    func(); // Warm-up, fills the caches and lets lazily created things get created
+    std::vector<double> times;
+    times.reserve(static_cast<size_t>(runs));
+    for (int run{0}; run < runs; run++) {
+        const auto start{std::chrono::steady_clock::now()};
+        func();
+        const std::chrono::duration<double, std::nano> elapsed{std::chrono::steady_clock::now() - start};
+        times.push_back(elapsed.count());
+    }
+    std::nth_element(times.begin(), times.begin() + runs / 2, times.end());
+    return times[static_cast<size_t>(runs / 2)];
+}
+/**
+ * Times func() and prints one line with the time per call, and per operation when a call does several.
+ * @param name
+ * @param operations Number of operations done by one call of func, e.g. the number of entities visited.
+ * @param func
+ * @param runs
+ * @return the median time of one call in nanoseconds.
+ */
+template <typename Func>
+double report(const char *name, size_t operations, Func func, int runs = 9)
+{
+    const double time{median(func, runs)};
+    std::printf("  %-48s %10.3f ms %10.2f ns/op\n", name, time * 1e-6, time / static_cast<double>(operations));
+    return time;
+}
+/// Where keep() stores results. At namespace scope, so storing into it doesn't warn as set but never used.
+template <typename Type>
+inline volatile Type sink{};
+/**
+ * Stores a result where the compiler can't see it being thrown away, so the work producing it isn't optimized out.
+ * @param value
+ */
+template <typename Type>
+void keep(Type value)
+{
+    sink<Type> = value;
+}
+} // namespace bench
+
+#endif // BENCHMARK_H
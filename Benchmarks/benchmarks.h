@@ -0,0 +1,42 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+/**
+ * Benchmark suites, each timing one of the engine's hot paths outside the editor.
+ * Every suite prints its own results, see main.cpp for running them.
+ */
+
+/**
+ * Registry::get(), contains() and system() lookups by type.
+ */
+void benchLookup();
+/**
+ * View and Group iteration over one to three component types, with whichever storage backend the engine is built with.
+ */
+void benchIteration();
+/**
+ * View::par_each() on 1, 2, 4 and 8 threads against the single threaded each().
+ */
+void benchParallel();
+/**
+ * Pool churn: adding and removing components, and the pool copies made by the editor's Play/Stop snapshots.
+ */
+void benchChurn();
+/**
+ * The gsl::simd Matrix4x4 kernels against their scalar versions and the builders they replace.
+ */
+void benchSimd();
+/**
+ * Turning billboards towards the camera and composing their matrices, with Euler angles and with quaternions.
+ */
+void benchBillboards();
+/**
+ * Tower ranges and bullet hits found through the SpatialGrid against testing every gnome, with 5k gnomes, 200 towers and 2k bullets.
+ */
+void benchGrid();
+/**
+ * Sphere against sphere overlaps found by SweepAndPrune against testing every pair, for 1k to 20k spheres.
+ */
+void benchSweep();
+
+#endif // BENCHMARKS_H
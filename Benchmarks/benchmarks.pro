@@ -0,0 +1,19 @@
+TEMPLATE    = app
+CONFIG      += console
+CONFIG      -= app_bundle
+
+TARGET      = benchmarks
+
+# Builds the whole engine, minus its main(), into a console program timing the hot paths.
+include(../INNgine2019.pri)
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    benchmark.h \
+    benchmarks.h
+
+SOURCES += main.cpp \
+    collisionbenchmarks.cpp \
+    ecsbenchmarks.cpp \
+    mathbenchmarks.cpp
@@ -0,0 +1,179 @@
+#include "benchmark.h"
+#include "benchmarks.h"
+#include "gsl_simd.h"
+#include "paircache.h"
+#include "spatialgrid.h"
+#include "sweepandprune.h"
+#include <cmath>
+#include <random>
+
+namespace {
+using vec3 = gsl::Vector3D;
+
+/// A tower defense wave: gnomes walking the level, towers looking for them and bullets flying at them.
+constexpr size_t GnomeCount{5000};
+constexpr size_t TowerCount{200};
+constexpr size_t BulletCount{2000};
+/// Side of the square level, in world units.
+constexpr float LevelSize{200.f};
+constexpr float TowerRange{8.f};
+constexpr float BulletRadius{0.25f};
+constexpr float SphereRadius{0.5f};
+
+struct Box {
+    vec3 min, max;
+};
+struct Ball {
+    vec3 center;
+    float radius;
+};
+/**
+ * Squared distance from a point to a box, 0 if the box contains it. A sphere hits the box when this is below its squared radius, like in SphereAABB().
+ * @param point
+ * @param box
+ * @return
+ */
+float distanceSq(const vec3 &point, const Box &box)
+{
+    float distance{0.f};
+    for (int axis{0}; axis < 3; axis++) {
+        const float value{point[axis]};
+        if (value < box.min[axis])
+            distance += (box.min[axis] - value) * (box.min[axis] - value);
+        else if (value > box.max[axis])
+            distance += (value - box.max[axis]) * (value - box.max[axis]);
+    }
+    return distance;
+}
+/**
+ * Spheres spread over the level, or over a square of the given side.
+ * @param random
+ * @param count
+ * @param radius
+ * @param side
+ * @return
+ */
+std::vector<Ball> randomBalls(std::mt19937 &random, size_t count, float radius, float side = LevelSize)
+{
+    std::uniform_real_distribution<float> position{0.f, side}, height{0.f, 2.f};
+    std::vector<Ball> balls(count);
+    for (auto &ball : balls)
+        ball = Ball{vec3{position(random), height(random), position(random)}, radius};
+    return balls;
+}
+} // namespace
+
+void benchGrid()
+{
+    std::printf("grid: %zu gnomes, %zu towers and %zu bullets on a %.0f x %.0f level\n", GnomeCount, TowerCount, BulletCount, LevelSize, LevelSize);
+    std::mt19937 random{1};
+    std::uniform_real_distribution<float> position{0.f, LevelSize};
+    std::vector<Box> gnomes(GnomeCount);
+    for (auto &gnome : gnomes) {
+        const vec3 feet{position(random), 0.f, position(random)};
+        gnome = Box{feet - vec3{0.5f, 0.f, 0.5f}, feet + vec3{0.5f, 2.f, 0.5f}};
+    }
+    const std::vector<Ball> towers{randomBalls(random, TowerCount, TowerRange)};
+    const std::vector<Ball> bullets{randomBalls(random, BulletCount, BulletRadius)};
+    SpatialGrid grid;
+    PairCache towerRanges, bulletHits;
+    std::vector<GLfloat> distances;
+
+    // What the collision system did before the grid, every tower and bullet against every gnome
+    const auto bruteForce = [&](const std::vector<Ball> &spheres, PairCache &pairs) {
+        pairs.begin();
+        for (GLuint sphere{0}; sphere < spheres.size(); sphere++) {
+            const float hitDistanceSq{spheres[sphere].radius * spheres[sphere].radius};
+            for (GLuint gnome{0}; gnome < gnomes.size(); gnome++) {
+                if (distanceSq(spheres[sphere].center, gnomes[gnome]) < hitDistanceSq)
+                    pairs.add(sphere, gnome);
+            }
+        }
+        pairs.end();
+    };
+    const auto buildGrid = [&] {
+        grid.clear();
+        for (GLuint gnome{0}; gnome < gnomes.size(); gnome++)
+            grid.insert(gnome, gnomes[gnome].min, gnomes[gnome].max);
+        grid.build();
+    };
+    // What CollisionSystem::runAABBSimulations() does, the gnomes in the cells around a sphere tested a cell at a time
+    const auto queryGrid = [&](const std::vector<Ball> &spheres, PairCache &pairs) {
+        pairs.begin();
+        for (GLuint sphere{0}; sphere < spheres.size(); sphere++) {
+            const vec3 &center{spheres[sphere].center};
+            const vec3 reach{spheres[sphere].radius, spheres[sphere].radius, spheres[sphere].radius};
+            const GLfloat point[3]{center.x, center.y, center.z};
+            const float hitDistanceSq{spheres[sphere].radius * spheres[sphere].radius};
+            grid.queryCells(center - reach, center + reach, [&](const GLuint *items, const GLfloat *const min[3], const GLfloat *const max[3], size_t count) {
+                distances.resize(count);
+                gsl::simd::boxDistancesSq(count, min, max, point, distances.data());
+                for (size_t i{0}; i < count; i++) {
+                    if (distances[i] < hitDistanceSq)
+                        pairs.add(sphere, items[i]);
+                }
+            });
+        }
+        pairs.end();
+    };
+
+    bench::report("tower ranges, every gnome", TowerCount, [&] { bruteForce(towers, towerRanges); });
+    bench::report("bullet hits, every gnome", BulletCount, [&] { bruteForce(bullets, bulletHits); });
+    const size_t bruteRanges{towerRanges.size()}, bruteHits{bulletHits.size()};
+    bench::report("grid build", GnomeCount, buildGrid);
+    bench::report("tower ranges, grid", TowerCount, [&] { queryGrid(towers, towerRanges); });
+    bench::report("bullet hits, grid", BulletCount, [&] { queryGrid(bullets, bulletHits); });
+    bench::report("grid build + tower ranges + bullet hits", TowerCount + BulletCount, [&] {
+        buildGrid();
+        queryGrid(towers, towerRanges);
+        queryGrid(bullets, bulletHits);
+    });
+    if (towerRanges.size() != bruteRanges || bulletHits.size() != bruteHits)
+        std::printf("  The grid found %zu ranges and %zu hits, brute force %zu and %zu\n", towerRanges.size(), bulletHits.size(), bruteRanges, bruteHits);
+}
+
+void benchSweep()
+{
+    std::printf("sweep: spheres of radius %.1f, as many per square unit at every count\n", static_cast<double>(SphereRadius));
+    for (size_t count : {1000, 5000, 10000, 20000}) {
+        std::mt19937 random{1};
+        // A 200 x 200 level at 20000 spheres
+        std::vector<Ball> spheres{randomBalls(random, count, SphereRadius, LevelSize * std::sqrt(count / 20000.f))};
+        size_t brutePairs{0}, sweepPairs{0};
+        char name[64];
+
+        // What the collision system did before the sweep, every sphere against every other one
+        std::snprintf(name, sizeof(name), "every pair, %zu spheres", count);
+        bench::report(name, count, [&] {
+            brutePairs = 0;
+            for (size_t i{0}; i < spheres.size(); i++) {
+                for (size_t j{i + 1}; j < spheres.size(); j++) {
+                    const vec3 offset{spheres[i].center - spheres[j].center};
+                    const float reach{spheres[i].radius + spheres[j].radius};
+                    brutePairs += vec3::dot(offset, offset) < reach * reach;
+                }
+            }
+        });
+        // Everything moves a little every frame, so the sweep sorts a nearly sorted list like it does in a game
+        SweepAndPrune sweep;
+        float step{0.01f};
+        std::snprintf(name, sizeof(name), "sweep and prune, %zu spheres", count);
+        bench::report(name, count, [&] {
+            step = -step;
+            sweep.begin();
+            for (GLuint i{0}; i < spheres.size(); i++) {
+                spheres[i].center.x += step;
+                const vec3 reach{spheres[i].radius, spheres[i].radius, spheres[i].radius};
+                sweep.update(i, spheres[i].center - reach, spheres[i].center + reach);
+            }
+            sweepPairs = 0;
+            sweep.forEachPair([&](GLuint item, GLuint otherItem) {
+                const vec3 offset{spheres[item].center - spheres[otherItem].center};
+                const float reach{spheres[item].radius + spheres[otherItem].radius};
+                sweepPairs += vec3::dot(offset, offset) < reach * reach;
+            });
+        });
+        if (sweepPairs != brutePairs)
+            std::printf("  The sweep found %zu pairs, brute force %zu\n", sweepPairs, brutePairs);
+    }
+}
@@ -0,0 +1,185 @@
+#include "benchmark.h"
+#include "benchmarks.h"
+#include "registry.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+
+namespace {
+/// Entities made by every ECS suite.
+constexpr size_t EntityCount{100000};
+/**
+ * System doing nothing, only there to be looked up.
+ */
+class LookupSystem : public ISystem {
+public:
+    void update(DeltaTime = 0.016) override {}
+};
+} // namespace
+
+void benchLookup()
+{
+    std::printf("lookup: %zu entities with a Transform, every second one with a Mesh\n", EntityCount);
+    Registry *registry{Registry::instance()};
+    registry->registerComponent<EInfo>();
+    registry->registerComponent<Transform>();
+    registry->registerComponent<Mesh>();
+    registry->registerSystem<LookupSystem>();
+    std::vector<GLuint> entities;
+    entities.reserve(EntityCount);
+    for (size_t i{0}; i < EntityCount; i++) {
+        entities.push_back(registry->makeEntity<Transform>("", false));
+        if (i % 2 == 0)
+            registry->add<Mesh>(entities.back());
+    }
+    std::vector<GLuint> shuffled{entities};
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937{1});
+
+    bench::report("get<Transform>, in creation order", EntityCount, [&] {
+        float sum{0.f};
+        for (auto entity : entities)
+            sum += registry->get<Transform>(entity).localPosition.x;
+        bench::keep(sum);
+    });
+    bench::report("get<Transform>, in random order", EntityCount, [&] {
+        float sum{0.f};
+        for (auto entity : shuffled)
+            sum += registry->get<Transform>(entity).localPosition.x;
+        bench::keep(sum);
+    });
+    bench::report("contains<Transform, Mesh>", EntityCount, [&] {
+        size_t found{0};
+        for (auto entity : entities)
+            found += registry->contains<Transform, Mesh>(entity);
+        bench::keep(found);
+    });
+    bench::report("system<LookupSystem>()", EntityCount, [&] {
+        size_t found{0};
+        for (size_t i{0}; i < EntityCount; i++)
+            found += registry->system<LookupSystem>() != nullptr;
+        bench::keep(found);
+    });
+    registry->clearScene();
+}
+
+void benchIteration()
+{
+#ifdef CJK_ARCHETYPE_STORAGE
+    std::printf("iteration: archetype tables, %zu entities with a Transform, every second one with a Mesh, every third one with a Bullet\n", EntityCount);
+#else
+    std::printf("iteration: sparse set pools, %zu entities with a Transform, every second one with a Mesh, every third one with a Bullet\n", EntityCount);
+#endif
+    Registry *registry{Registry::instance()};
+    registry->registerComponent<EInfo>();
+    registry->registerComponent<Transform>();
+    registry->registerComponent<Mesh>();
+    registry->registerComponent<Bullet>();
+    // Made before the entities, so it keeps its members packed as they're added
+    auto group{registry->group<Transform, Mesh>()};
+    for (size_t i{0}; i < EntityCount; i++) {
+        const GLuint entity{registry->makeEntity<Transform>("", false)};
+        if (i % 2 == 0)
+            registry->add<Mesh>(entity);
+        if (i % 3 == 0)
+            registry->add<Bullet>(entity);
+    }
+
+    bench::report("view<Transform>().each()", EntityCount, [&] {
+        registry->view<Transform>().each([](GLuint, Transform &transform) {
+            transform.localPosition.x += 1.f;
+        });
+    });
+    bench::report("view<Transform, Mesh>().each()", EntityCount / 2, [&] {
+        registry->view<Transform, Mesh>().each([](GLuint, Transform &transform, Mesh &mesh) {
+            transform.localPosition.x += static_cast<float>(mesh.verticeCount);
+        });
+    });
+    bench::report("view<Transform, Mesh, Bullet>().each()", EntityCount / 6, [&] {
+        registry->view<Transform, Mesh, Bullet>().each([](GLuint, Transform &transform, Mesh &mesh, Bullet &bullet) {
+            transform.localPosition.x += static_cast<float>(mesh.verticeCount) + bullet.lifeTime;
+        });
+    });
+    bench::report("group<Transform, Mesh>().each()", EntityCount / 2, [&] {
+        group.each([](GLuint, Transform &transform, Mesh &mesh) {
+            transform.localPosition.x += static_cast<float>(mesh.verticeCount);
+        });
+    });
+    bench::report("for (entity : view<Transform, Mesh>()) get()", EntityCount / 2, [&] {
+        auto view{registry->view<Transform, Mesh>()};
+        for (auto entity : view) {
+            auto [transform, mesh]{view.get<Transform, Mesh>(entity)};
+            transform.localPosition.x += static_cast<float>(mesh.verticeCount);
+        }
+    });
+    registry->clearScene();
+}
+
+void benchParallel()
+{
+    std::printf("parallel: %zu entities with a Transform, %u hardware threads\n", EntityCount, std::thread::hardware_concurrency());
+    Registry *registry{Registry::instance()};
+    registry->registerComponent<EInfo>();
+    registry->registerComponent<Transform>();
+    const auto entities{registry->createEntities<Transform>(EntityCount)};
+    GLuint highest{0};
+    for (auto entity : entities)
+        highest = std::max(highest, Entity::index(entity));
+    std::vector<gsl::Matrix4x4> matrices(highest + 1);
+    // Roughly what composing the dirty local matrices costs per entity, and a light update bound by memory instead
+    const auto compose = [&matrices](GLuint entity, Transform &transform) {
+        matrices[Entity::index(entity)] = gsl::Matrix4x4::composeTRS(transform.localPosition, transform.localOrientation, transform.localScale);
+    };
+    const auto move = [](GLuint, Transform &transform) {
+        transform.localPosition.x += 1.f;
+    };
+
+    bench::report("each(), compose matrix", EntityCount, [&] { registry->view<Transform>().each(compose); });
+    bench::report("each(), move", EntityCount, [&] { registry->view<Transform>().each(move); });
+    for (size_t threads : {1, 2, 4, 8}) {
+        ThreadPool::setThreadCount(threads);
+        char name[64];
+        std::snprintf(name, sizeof(name), "par_each(), compose matrix, %zu threads", threads);
+        bench::report(name, EntityCount, [&] { registry->view<Transform>().par_each(compose); });
+        std::snprintf(name, sizeof(name), "par_each(), move, %zu threads", threads);
+        bench::report(name, EntityCount, [&] { registry->view<Transform>().par_each(move); });
+    }
+    ThreadPool::setThreadCount(std::thread::hardware_concurrency());
+    registry->clearScene();
+}
+
+void benchChurn()
+{
+    std::printf("churn: components added to and removed from %zu entities, and Play/Stop snapshots of them\n", EntityCount);
+    Registry *registry{Registry::instance()};
+    registry->registerComponent<EInfo>();
+    registry->registerComponent<Transform>();
+    registry->registerComponent<AIComponent>();
+    std::vector<GLuint> entities;
+    entities.reserve(EntityCount);
+    for (size_t i{0}; i < EntityCount; i++)
+        entities.push_back(registry->makeEntity("", false));
+
+    // Removing in creation order moves the pool's last component into every freed slot
+    bench::report("add + remove Transform", EntityCount, [&] {
+        for (auto entity : entities)
+            registry->add<Transform>(entity);
+        for (auto entity : entities)
+            registry->remove<Transform>(entity);
+    });
+    bench::report("add + remove AIComponent", EntityCount, [&] {
+        for (auto entity : entities)
+            registry->add<AIComponent>(entity);
+        for (auto entity : entities)
+            registry->remove<AIComponent>(entity);
+    });
+    for (auto entity : entities) {
+        registry->add<Transform>(entity);
+        registry->add<AIComponent>(entity);
+    }
+    bench::report("makeSnapshot() + loadSnapshot()", EntityCount, [&] {
+        registry->makeSnapshot();
+        registry->loadSnapshot();
+    });
+    registry->clearScene();
+}
@@ -0,0 +1,41 @@
+#include "benchmarks.h"
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+/**
+ * Runs every benchmark suite, or only the ones named on the command line, e.g. "benchmarks lookup".
+ * Build in release, the numbers from a debug build say nothing about the engine's real speed.
+ */
+int main(int argc, char *argv[])
+{
+    const std::vector<std::pair<const char *, void (*)()>> suites{
+        {"lookup", benchLookup},
+        {"iteration", benchIteration},
+        {"parallel", benchParallel},
+        {"churn", benchChurn},
+        {"simd", benchSimd},
+        {"billboards", benchBillboards},
+        {"grid", benchGrid},
+        {"sweep", benchSweep},
+    };
+    bool ran{false};
+    for (const auto &[name, suite] : suites) {
+        bool selected{argc < 2};
+        for (int arg{1}; arg < argc; arg++)
+            selected = selected || std::strcmp(argv[arg], name) == 0;
+        if (selected) {
+            suite();
+            ran = true;
+        }
+    }
+    if (!ran) {
+        std::printf("Unknown suite. Available suites:");
+        for (const auto &suite : suites)
+            std::printf(" %s", suite.first);
+        std::printf("\n");
+        return 1;
+    }
+    return 0;
+}
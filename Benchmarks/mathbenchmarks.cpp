@@ -0,0 +1,208 @@
+#include "benchmark.h"
+#include "benchmarks.h"
+#include "gsl_simd.h"
+#include "matrix4x4.h"
+#include "quaternion.h"
+#include <random>
+
+namespace {
+/// Matrices every kernel is run over, few enough to stay in the cache so the arithmetic is what's measured.
+constexpr size_t MatrixCount{1024};
+/// Passes over the matrices per timed call.
+constexpr size_t Passes{64};
+constexpr size_t Operations{MatrixCount * Passes};
+/// Billboards turned and composed by the billboard suite, about what a forest of sprites puts in a scene.
+constexpr size_t BillboardCount{5000};
+
+struct TRS {
+    gsl::Vector3D translation, rotation, scale;
+};
+/**
+ * Random positions, Euler angles and scales, like the ones found in a scene.
+ * @param random
+ * @return
+ */
+std::vector<TRS> randomTRS(std::mt19937 &random)
+{
+    std::uniform_real_distribution<float> position{-50.f, 50.f}, angle{-180.f, 180.f}, scale{0.5f, 2.f};
+    std::vector<TRS> values(MatrixCount);
+    for (auto &value : values) {
+        value.translation = gsl::Vector3D{position(random), position(random), position(random)};
+        value.rotation = gsl::Vector3D{angle(random), angle(random), angle(random)};
+        value.scale = gsl::Vector3D{scale(random), scale(random), scale(random)};
+    }
+    return values;
+}
+/**
+ * Build model matrices the way the engine used to, one builder at a time.
+ * @param values
+ * @param matrices
+ */
+void buildModelMatrices(const std::vector<TRS> &values, std::vector<gsl::Matrix4x4> &matrices)
+{
+    for (size_t i{0}; i < values.size(); i++) {
+        matrices[i].setToIdentity();
+        matrices[i].translate(values[i].translation);
+        matrices[i].rotateX(values[i].rotation.x);
+        matrices[i].rotateY(values[i].rotation.y);
+        matrices[i].rotateZ(values[i].rotation.z);
+        matrices[i].scale(values[i].scale);
+    }
+}
+} // namespace
+
+void benchSimd()
+{
+    std::printf("simd: %zu affine matrices, %zu passes, %s kernels\n", MatrixCount, Passes, gsl::simd::kernelName());
+    std::mt19937 random{1};
+    const std::vector<TRS> values{randomTRS(random)};
+    std::vector<gsl::Matrix4x4> matrices(MatrixCount);
+    buildModelMatrices(values, matrices);
+    std::vector<gsl::Matrix4x4> results(MatrixCount);
+
+    bench::report("Matrix4x4 * Matrix4x4", Operations, [&] {
+        for (size_t pass{0}; pass < Passes; pass++) {
+            for (size_t i{0}; i < MatrixCount; i++)
+                results[i] = matrices[i] * matrices[MatrixCount - 1 - i];
+        }
+    });
+    bench::report("simd::multiply()", Operations, [&] {
+        for (size_t pass{0}; pass < Passes; pass++) {
+            for (size_t i{0}; i < MatrixCount; i++)
+                gsl::simd::multiply(matrices[i].constData(), matrices[MatrixCount - 1 - i].constData(), results[i].constData());
+        }
+    });
+    bench::report("simd::scalar::multiply()", Operations, [&] {
+        for (size_t pass{0}; pass < Passes; pass++) {
+            for (size_t i{0}; i < MatrixCount; i++)
+                gsl::simd::scalar::multiply(matrices[i].constData(), matrices[MatrixCount - 1 - i].constData(), results[i].constData());
+        }
+    });
+    bench::report("Matrix4x4 * Vector4D", Operations, [&] {
+        float sum{0.f};
+        for (size_t pass{0}; pass < Passes; pass++) {
+            for (size_t i{0}; i < MatrixCount; i++)
+                sum += (matrices[i] * gsl::Vector4D{values[i].translation, 1.f}).x;
+        }
+        bench::keep(sum);
+    });
+    bench::report("simd::transform()", Operations, [&] {
+        float sum{0.f};
+        for (size_t pass{0}; pass < Passes; pass++) {
+            for (size_t i{0}; i < MatrixCount; i++) {
+                const GLfloat in[4]{values[i].translation.x, values[i].translation.y, values[i].translation.z, 1.f};
+                GLfloat out[4];
+                gsl::simd::transform(matrices[i].constData(), in, out);
+                sum += out[0];
+            }
+        }
+        bench::keep(sum);
+    });
+    bench::report("simd::scalar::transform()", Operations, [&] {
+        float sum{0.f};
+        for (size_t pass{0}; pass < Passes; pass++) {
+            for (size_t i{0}; i < MatrixCount; i++) {
+                const GLfloat in[4]{values[i].translation.x, values[i].translation.y, values[i].translation.z, 1.f};
+                GLfloat out[4];
+                gsl::simd::scalar::transform(matrices[i].constData(), in, out);
+                sum += out[0];
+            }
+        }
+        bench::keep(sum);
+    });
+    bench::report("inverse()", Operations, [&] {
+        for (size_t pass{0}; pass < Passes; pass++) {
+            for (size_t i{0}; i < MatrixCount; i++) {
+                results[i] = matrices[i];
+                results[i].inverse();
+            }
+        }
+    });
+    bench::report("affineInverse()", Operations, [&] {
+        for (size_t pass{0}; pass < Passes; pass++) {
+            for (size_t i{0}; i < MatrixCount; i++) {
+                results[i] = matrices[i];
+                results[i].affineInverse();
+            }
+        }
+    });
+    bench::report("simd::scalar::affineInverse()", Operations, [&] {
+        for (size_t pass{0}; pass < Passes; pass++) {
+            for (size_t i{0}; i < MatrixCount; i++)
+                gsl::simd::scalar::affineInverse(matrices[i].constData(), results[i].constData());
+        }
+    });
+    bench::report("translate(), rotateX/Y/Z(), scale()", Operations, [&] {
+        for (size_t pass{0}; pass < Passes; pass++)
+            buildModelMatrices(values, results);
+    });
+    bench::report("composeTRS(), Euler angles", Operations, [&] {
+        for (size_t pass{0}; pass < Passes; pass++) {
+            for (size_t i{0}; i < MatrixCount; i++)
+                results[i] = gsl::Matrix4x4::composeTRS(values[i].translation, values[i].rotation, values[i].scale);
+        }
+    });
+}
+
+void benchBillboards()
+{
+    std::printf("billboards: %zu upright billboards turned towards the camera, and their model matrices composed\n", BillboardCount);
+    std::mt19937 random{1};
+    std::uniform_real_distribution<float> position{-100.f, 100.f}, scale{0.5f, 2.f};
+    std::vector<gsl::Vector3D> positions(BillboardCount), scales(BillboardCount), directions(BillboardCount), rotations(BillboardCount);
+    for (size_t i{0}; i < BillboardCount; i++) {
+        positions[i] = gsl::Vector3D{position(random), 0.f, position(random)};
+        scales[i] = gsl::Vector3D{scale(random), scale(random), scale(random)};
+    }
+    // Directions from every billboard to the camera, with the height cancelled like BillBoard::constantYUp does
+    const gsl::Vector3D camera{0.f, 10.f, 0.f};
+    for (size_t i{0}; i < BillboardCount; i++) {
+        directions[i] = gsl::Vector3D{camera.x, positions[i].y, camera.z} - positions[i];
+        directions[i].normalize();
+    }
+    std::vector<gsl::Quaternion> orientations(BillboardCount);
+    std::vector<gsl::Matrix4x4> matricesTR(BillboardCount), matricesTRS(BillboardCount);
+
+    bench::report("setRotationToVector() + decomposed()", BillboardCount, [&] {
+        for (size_t i{0}; i < BillboardCount; i++) {
+            gsl::Matrix4x4 rotation(true);
+            rotation.setRotationToVector(directions[i]);
+            rotations[i] = std::get<2>(gsl::Matrix4x4::decomposed(rotation));
+        }
+    });
+    bench::report("Quaternion::lookRotation()", BillboardCount, [&] {
+        for (size_t i{0}; i < BillboardCount; i++)
+            orientations[i] = gsl::Quaternion::lookRotation(directions[i]);
+    });
+    bench::report("composeTRS(), Euler angles", BillboardCount, [&] {
+        for (size_t i{0}; i < BillboardCount; i++)
+            matricesTRS[i] = gsl::Matrix4x4::composeTRS(positions[i], rotations[i], scales[i]);
+    });
+    bench::report("composeTRS(), quaternion", BillboardCount, [&] {
+        for (size_t i{0}; i < BillboardCount; i++)
+            matricesTRS[i] = gsl::Matrix4x4::composeTRS(positions[i], orientations[i], scales[i]);
+    });
+
+    // The batch kernel reads every value from its own array, the way MovementSystem gathers them
+    std::vector<GLfloat> values[10];
+    for (auto &array : values)
+        array.resize(BillboardCount);
+    for (size_t i{0}; i < BillboardCount; i++) {
+        values[0][i] = positions[i].x;
+        values[1][i] = positions[i].y;
+        values[2][i] = positions[i].z;
+        values[3][i] = orientations[i].x;
+        values[4][i] = orientations[i].y;
+        values[5][i] = orientations[i].z;
+        values[6][i] = orientations[i].w;
+        values[7][i] = scales[i].x;
+        values[8][i] = scales[i].y;
+        values[9][i] = scales[i].z;
+    }
+    const GLfloat *const translation[3]{values[0].data(), values[1].data(), values[2].data()};
+    const GLfloat *const orientation[4]{values[3].data(), values[4].data(), values[5].data(), values[6].data()};
+    const GLfloat *const scale3[3]{values[7].data(), values[8].data(), values[9].data()};
+    bench::report("simd::composeTRS() batch, quaternions", BillboardCount, [&] {
+        gsl::simd::composeTRS(BillboardCount, translation, orientation, scale3, matricesTR.data(), matricesTRS.data());
+    });
+}
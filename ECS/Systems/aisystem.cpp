@@ -1,11 +1,17 @@
 #include "aisystem.h"
+#include "collisionsystem.h"
 #include "gsl_math.h"
 #include "registry.h"
 #include "resourcemanager.h"
+#include "textureshader.h"
 #include "hud.h"
 
 AISystem::AISystem() : registry(Registry::instance())
 {
+    addReads<Sphere>();
+    addWrites<Transform, AIComponent, TowerComponent, Bullet, BSplinePoint>(); // Moves the enemies along their paths
+    mStructural = true; // Spawns enemies and bullets, and removes them again
+    mContextThread = true;
 }
 
 void AISystem::update(DeltaTime)
@@ -31,7 +37,7 @@ void AISystem::updatePlayOnly(DeltaTime dt)
         std::optional<NPCevents> event;
         switch (ai.state) {
         case NPCstates::MOVE:
-            event = move(dt, ai, transform);
+            event = move(dt, entity, ai, transform);
             if (event) {
                 ai.notification_queue.push(event.value());
             }
@@ -49,11 +55,10 @@ void AISystem::updatePlayOnly(DeltaTime dt)
 
     auto towerView{registry->view<TowerComponent, Sphere, Transform>()};
     for (auto entity : towerView) {
-        auto [ai, sphere, transform]{towerView.get<TowerComponent, Sphere, Transform>(entity)};
+        auto [ai, transform]{towerView.get<TowerComponent, Transform>(entity)};
         switch (ai.state) {
         case TowerStates::IDLE:
-            // scanning for monsters
-            detectEnemies(ai, sphere);
+            // scanning for monsters, see detectEnemies()
             break;
         case TowerStates::ATTACK:
             if (ai.curCooldown >= 0.f)
@@ -68,7 +73,9 @@ void AISystem::updatePlayOnly(DeltaTime dt)
             break;
         }
     }
+    detectEnemies();
     bulletLifeTime(dt);
+    registry->flush();
 }
 
 void AISystem::bulletLifeTime(DeltaTime dt)
@@ -79,7 +86,7 @@ void AISystem::bulletLifeTime(DeltaTime dt)
         if (bullet.lifeTime >= 0.f)
             bullet.lifeTime -= dt;
         if (bullet.lifeTime <= 0.f) {
-            registry->removeEntity(entity);
+            registry->commands().destroy(entity);
         }
     }
 }
@@ -112,20 +119,40 @@ void AISystem::spawnWave(DeltaTime dt)
     }
 }
 
-void AISystem::detectEnemies(TowerComponent &ai, Sphere &sphere)
+void AISystem::detectEnemies()
 {
-    if (!sphere.overlappedEntities.empty()) {
-        for (auto entity : sphere.overlappedEntities.getList()) {
-            if (entity != ai.lastTarget) {
-                ai.lastTarget = ai.targetID;
-                ai.targetID = entity;
-            }
-        }
-        ai.state = TowerStates::ATTACK;
-    }
-    else {
-        ai.state = TowerStates::IDLE;
+    auto collisionSystem{registry->system<CollisionSystem>()};
+    if (!collisionSystem)
+        return;
+    const PairCache &ranges{collisionSystem->towerRanges()};
+    // A tower whose target left its range looks for a new one
+    for (const auto &[tower, enemy] : ranges.exited()) {
+        if (!registry->contains<TowerComponent>(tower))
+            continue;
+        auto &ai{registry->get<TowerComponent>(tower)};
+        if (ai.state == TowerStates::ATTACK && ai.targetID == enemy)
+            ai.state = TowerStates::IDLE;
     }
+    // Idle towers target the enemies in their range, both the new ones and the ones that were there already
+    std::vector<GLuint> attackers;
+    auto detect = [&](const PairCache::Pair &pair) {
+        if (!registry->contains<TowerComponent>(pair.first))
+            return;
+        auto &ai{registry->get<TowerComponent>(pair.first)};
+        if (ai.state != TowerStates::IDLE)
+            return;
+        if (pair.second != ai.lastTarget) {
+            ai.lastTarget = ai.targetID;
+            ai.targetID = pair.second;
+        }
+        attackers.push_back(pair.first);
+    };
+    for (const auto &pair : ranges.entered())
+        detect(pair);
+    for (const auto &pair : ranges.stayed())
+        detect(pair);
+    for (GLuint tower : attackers)
+        registry->get<TowerComponent>(tower).state = TowerStates::ATTACK;
 }
 
 void AISystem::attack(TowerComponent &tower, Transform &t)
@@ -135,15 +162,22 @@ void AISystem::attack(TowerComponent &tower, Transform &t)
     // 2 Controlpoints -> First control point is offset by some value on y axis, 2nd is set at target location
 
     // Standard/Projectile type
-    if (registry->contains<Transform>(tower.targetID) && tower.targetID != tower.lastTarget) {
+    if (registry->valid(tower.targetID) && registry->contains<Transform>(tower.targetID) && tower.targetID != tower.lastTarget) {
         auto &trans{registry->get<Transform>(tower.targetID)};
-        GLuint bulletID = ResourceManager::instance()->makeOctBall("projectile", 1);
-        vec3 velocity{(trans.localPosition - t.localPosition).normalized()}; // get the vector (line) from tower to enemy, normalize to get the general direction.
-        registry->add<Bullet>(bulletID, velocity, tower.damage, tower.projectileSpeed);
-        registry->add<Sphere>(bulletID, vec3{0}, .25f, false);
-        registry->get<Transform>(bulletID).localPosition = t.position;
-        registry->get<Transform>(bulletID).localScale = vec3{0.25, 0.25, 0.25};
-        registry->get<Transform>(bulletID).matrixOutdated = true;
+        auto factory{ResourceManager::instance()};
+        auto &commands{registry->commands()};
+        GLuint bulletID{commands.create("projectile")};
+        vec3 direction{(trans.localPosition - t.localPosition).normalized()}; // get the vector (line) from tower to enemy, normalize to get the general direction.
+        commands.add<Transform>(bulletID, t.position, vec3{0}, vec3{0.25, 0.25, 0.25});
+        commands.add<Velocity>(bulletID, direction * tower.projectileSpeed);
+        commands.add<Material>(bulletID, factory->getShader<TextureShader>(), 0u, vec3{1, 1, 1});
+        commands.add<Mesh>(bulletID, factory->getBallMesh(1));
+        commands.add<Bullet>(bulletID, tower.damage);
+        Sphere collider{vec3{0}, .25f, false, CollisionLayer::BULLET};
+        // Bullets move several times their size every tick, so they're swept starting from the tower
+        collider.continuous = true;
+        collider.lastPosition = t.position;
+        commands.add<Sphere>(bulletID, collider);
     }
     else {
         tower.state = TowerStates::IDLE;
@@ -182,13 +216,13 @@ void AISystem::deathTimer(DeltaTime dt)
         if (curTimerCD >= 0.f)
             curTimerCD -= dt;
         if (curTimerCD <= 0.f) {
-            registry->removeEntity(entity);
+            registry->commands().destroy(entity);
             curTimerCD = curTimer;
         }
     }
 }
 
-std::optional<NPCevents> AISystem::move(DeltaTime dt, AIComponent &ai, Transform &transform)
+std::optional<NPCevents> AISystem::move(DeltaTime dt, GLuint entity, AIComponent &ai, Transform &transform)
 {
     float &t = ai.pathT; // shortcut
     t += dt * ai.moveSpeed;
@@ -199,7 +233,7 @@ std::optional<NPCevents> AISystem::move(DeltaTime dt, AIComponent &ai, Transform
 
     auto p{mCurve.eval(t)};
     transform.localPosition = p;
-    transform.matrixOutdated = true;
+    registry->transforms().markDirty(entity);
 
     if (endPoint) {
         return NPCevents::ENDPOINT_ARRIVED;
@@ -217,7 +251,7 @@ void AISystem::init()
 void AISystem::death(const GLuint entityID)
 {
     registry->getPlayer().gold += 20;
-    registry->removeEntity(entityID);
+    registry->commands().destroy(entityID);
     qDebug() << "Murdered another innocent gnome!";
 }
 
@@ -225,7 +259,7 @@ void AISystem::goalReached(const GLuint entityID)
 {
     HUD hud;
     registry->getPlayer().health--;
-    registry->removeEntity(entityID);   
+    registry->commands().destroy(entityID);
     hud.updatehealth();
 }
 
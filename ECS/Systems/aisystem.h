@@ -54,11 +54,12 @@ private:
     /**
      * @brief Moves the NPCs along the bspline from spawn to endpoint.
      * @param dt
+     * @param entity
      * @param ai
      * @param transform
      * @return
      */
-    std::optional<NPCevents> move(DeltaTime dt, AIComponent &ai, Transform &transform);
+    std::optional<NPCevents> move(DeltaTime dt, GLuint entity, AIComponent &ai, Transform &transform);
     /**
      * @brief Sets the control points for a bspline.
      * @param cps
@@ -89,11 +90,10 @@ private:
     Registry *registry;
 
     /**
-     * @brief NPC detection for the towers.
-     * @param ai
-     * @param sphere
+     * @brief NPC detection for the towers, from the enter, stay and exit events of CollisionSystem::towerRanges().
+     * Idle towers with enemies in range start attacking, and attacking towers whose target left their range go idle.
      */
-    void detectEnemies(TowerComponent &ai, Sphere &sphere);
+    void detectEnemies();
     /**
      * @brief Tower attack functionality, launches a projectile towards NPC position.
      * @param ai
@@ -2,141 +2,483 @@
 #include "aisystem.h"
 #include "cameracontroller.h"
 #include "components.h"
+#include "gsl_simd.h"
 #include "inputsystem.h"
 #include "registry.h"
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 CollisionSystem::CollisionSystem() : registry{Registry::instance()}
 {
+    addReads<Transform, AIComponent, TowerComponent, Bullet, EInfo>();
+    addWrites<AABB, Sphere, AIComponent>();
+    mStructural = true; // Removes bullets on impact
+    mContextThread = true;
+
+    // Only the bits of actual layers are set, so a layer colliding with nothing has a row of 0
+    mLayerMatrix.fill(layerBit(CollisionLayer::COUNT) - 1);
+    for (GLuint other{0}; other < static_cast<GLuint>(CollisionLayer::COUNT); other++) {
+        const CollisionLayer otherLayer{static_cast<CollisionLayer>(other)};
+        // Level tiles and decorations are only there to be picked
+        setLayersCollide(CollisionLayer::LEVEL, otherLayer, false);
+        setLayersCollide(CollisionLayer::DECORATION, otherLayer, false);
+        // Tower ranges and bullets are only looking for enemies
+        if (otherLayer != CollisionLayer::ENEMY && otherLayer != CollisionLayer::DEFAULT) {
+            setLayersCollide(CollisionLayer::TOWER_RANGE, otherLayer, false);
+            setLayersCollide(CollisionLayer::BULLET, otherLayer, false);
+        }
+    }
+    connect(registry, &Registry::entitiesRemoved, this, &CollisionSystem::onEntitiesRemoved);
+    connect(registry, &Registry::componentRemoved, this, &CollisionSystem::onComponentRemoved);
 }
 void CollisionSystem::update(DeltaTime)
 {
+    updateColliderTree();
 }
-void CollisionSystem::updatePlayOnly(DeltaTime deltaTime)
+void CollisionSystem::updatePlayOnly(DeltaTime)
 {
-    delta += deltaTime;
-    if (delta >= fixedDelta) {
-        delta = 0.f;
-        runAABBSimulations();
-        runSphereSimulations();
-    }
+    runAABBSimulations();
+    runSphereSimulations();
 }
 
 void CollisionSystem::runAABBSimulations()
 {
-    // possible groups - AABB + AIComponent, do two passes, one for Buildable + AABB, another for AABB + Bullet or whatever
+    // Broadphase: every enemy goes in the grid, so the towers and bullets only test the enemies in the cells around them
     auto view{registry->view<AIComponent, AABB, Transform>()};
     auto towerRangeView{registry->view<TowerComponent, Sphere>()};
+    mGrid.clear();
+    mEnemies.clear();
+    GLuint gridLayers{0};
     for (auto entity : view) {
-        auto &aabb{view.get<AABB>(entity)};
-        for (auto tower : towerRangeView) {
-            auto [sphere, towerComp]{towerRangeView.get<Sphere, TowerComponent>(tower)};
-            if (shouldCheckCollision(aabb, sphere) && towerComp.state != TowerStates::PLACEMENT)
-                if (SphereAABB(sphere, aabb)) {
-                    // NOTIFY FSM
-                    // send event notify ON ENTER (hei se på meg noe er i radius jippi)
-                    // sjekker for overlaps mot tårnets radius(sphere)
-                    if (aabb.overlapEvent && sphere.overlapEvent) {
-                        if (!sphere.overlappedEntities.contains(entity)) {
-                            sphere.overlappedEntities.insert(entity);
-                            qDebug() << "ON ENTER: Entity in range";
-                        }
-                    }
-                    collisions++;
-                    // notify FSM if needed
-                }
-        }
+        const auto &aabb{view.get<AABB>(entity)};
+        if (!canReach(aabb, AllLayers))
+            continue;
+        mGrid.insert(static_cast<GLuint>(mEnemies.size()), getMin(aabb), getMax(aabb));
+        mEnemies.push_back(entity);
+        gridLayers |= layerBit(aabb.layer);
+    }
+    mGrid.build();
 
-        auto bulletview{registry->view<Bullet, Sphere>()};
-        for (auto bulletID : bulletview) {
-            auto [bul, sphere]{bulletview.get<Bullet, Sphere>(bulletID)};
-            if (SphereAABB(sphere, aabb)) {
-                auto &ai{view.get<AIComponent>(entity)};
-                ai.health -= bul.damage;
-                ai.notification_queue.push(NPCevents::DAMAGE_TAKEN);
-                qDebug() << "Enemy health: " + QString::number(ai.health);
-                registry->removeEntity(bulletID);
+    // Narrow phase, the overlaps go in the pair caches which turn them into enter, stay and exit events
+    mTowerRanges.begin();
+    for (auto tower : towerRangeView) {
+        auto [sphere, towerComp]{towerRangeView.get<Sphere, TowerComponent>(tower)};
+        if (towerComp.state == TowerStates::PLACEMENT || !sphere.overlapEvent || !canReach(sphere, gridLayers))
+            continue;
+        const vec3 center{sphere.transform.modelMatrix.getPosition()};
+        const vec3 reach{sphereReach(sphere)};
+        const GLfloat point[3]{center.x, center.y, center.z};
+        const float hitDistanceSq{sphereHitDistanceSq(sphere)};
+        // Each cell's enemies are tested together, an enemy in several cells is tested once in each
+        mGrid.queryCells(center - reach, center + reach, [&](const GLuint *items, const GLfloat *const min[3], const GLfloat *const max[3], size_t count) {
+            mDistances.resize(count);
+            gsl::simd::boxDistancesSq(count, min, max, point, mDistances.data());
+            for (size_t i{0}; i < count; i++) {
+                if (mDistances[i] >= hitDistanceSq)
+                    continue;
+                const GLuint entity{mEnemies[items[i]]};
+                const auto &aabb{view.get<AABB>(entity)};
+                if (aabb.overlapEvent && shouldCheckCollision(aabb, sphere))
+                    mTowerRanges.add(tower, entity);
             }
-        }
+        });
     }
+    mTowerRanges.end();
 
-    // ON EXIT
-    for (auto tower : towerRangeView) {
-        auto &sphere{towerRangeView.get<Sphere>(tower)};
-        std::vector<GLuint> entities = sphere.overlappedEntities.getList();
-        for (size_t i{0}; i < entities.size(); i++) {
-            GLuint entity = entities[i];
-            if (view.contains(entity)) {
-                auto &aabb{view.get<AABB>(entity)};
-                if (!SphereAABB(sphere, aabb)) {
-                    sphere.overlappedEntities.remove(entity);
-                    qDebug() << "ON EXIT: Entity removed";
+    auto bulletview{registry->view<Bullet, Sphere>()};
+    mBulletHits.begin();
+    for (auto bulletID : bulletview) {
+        auto [bul, sphere]{bulletview.get<Bullet, Sphere>(bulletID)};
+        if (bul.lifeTime <= 0.f)
+            continue;
+        const vec3 center{sphere.transform.modelMatrix.getPosition()};
+        const vec3 start{sphere.continuous ? sphere.lastPosition.value_or(center) : center};
+        sphere.lastPosition = center;
+        if (!canReach(sphere, gridLayers))
+            continue;
+        const vec3 reach{sphereReach(sphere)};
+        if (sphere.continuous) {
+            // Only the first enemy along the path is hit
+            float firstHit{std::numeric_limits<float>::max()};
+            int hitEnemy{-1};
+            const vec3 pathMin{std::min(start.x, center.x), std::min(start.y, center.y), std::min(start.z, center.z)};
+            const vec3 pathMax{std::max(start.x, center.x), std::max(start.y, center.y), std::max(start.z, center.z)};
+            mGrid.queryCells(pathMin - reach, pathMax + reach, [&](const GLuint *items, const GLfloat *const min[3], const GLfloat *const max[3], size_t count) {
+                for (size_t i{0}; i < count; i++) {
+                    const vec3 boxMin{min[0][i], min[1][i], min[2][i]};
+                    const vec3 boxMax{max[0][i], max[1][i], max[2][i]};
+                    float time;
+                    if (!sweptSphereAABB(start, center, sphere.radius, boxMin, boxMax, time) || time >= firstHit)
+                        continue;
+                    const GLuint entity{mEnemies[items[i]]};
+                    if (shouldCheckCollision(sphere, view.get<AABB>(entity))) {
+                        firstHit = time;
+                        hitEnemy = static_cast<int>(entity);
+                    }
                 }
-            }
-            else {
-                sphere.overlappedEntities.remove(entity);
-                qDebug() << "Entity died of natural causes: Entity removed";
-            }
+            });
+            if (hitEnemy != -1)
+                mBulletHits.add(bulletID, static_cast<GLuint>(hitEnemy));
+            continue;
         }
+        const GLfloat point[3]{center.x, center.y, center.z};
+        const float hitDistanceSq{sphereHitDistanceSq(sphere)};
+        mGrid.queryCells(center - reach, center + reach, [&](const GLuint *items, const GLfloat *const min[3], const GLfloat *const max[3], size_t count) {
+            mDistances.resize(count);
+            gsl::simd::boxDistancesSq(count, min, max, point, mDistances.data());
+            for (size_t i{0}; i < count; i++) {
+                if (mDistances[i] >= hitDistanceSq)
+                    continue;
+                const GLuint entity{mEnemies[items[i]]};
+                if (shouldCheckCollision(sphere, view.get<AABB>(entity)))
+                    mBulletHits.add(bulletID, entity);
+            }
+        });
+    }
+    mBulletHits.end();
+    collisions += static_cast<int>(mTowerRanges.entered().size() + mBulletHits.entered().size());
+
+    // Bullets damage the first enemy they hit, and are spent
+    for (const auto &[bulletID, enemy] : mBulletHits.entered()) {
+        auto &bul{bulletview.get<Bullet>(bulletID)};
+        if (bul.lifeTime <= 0.f)
+            continue;
+        auto &ai{view.get<AIComponent>(enemy)};
+        ai.health -= bul.damage;
+        ai.notification_queue.push(NPCevents::DAMAGE_TAKEN);
+        bul.lifeTime = 0.f; // Spent, so it can't hit anything else before it's destroyed
+        registry->commands().destroy(bulletID);
     }
+    registry->flush();
 }
 void CollisionSystem::runSphereSimulations()
 {
-    auto view{registry->view<EInfo, Sphere>()};
+    // Broadphase: only the spheres whose bounds overlap are tested against each other
+    auto view{registry->view<Sphere>()};
+    GLuint sphereLayers{0};
+    for (auto entity : view)
+        sphereLayers |= layerBit(view.get(entity).layer);
+    mSweep.begin();
     for (auto entity : view) {
-        auto &sphere{view.get<Sphere>(entity)};
-        for (auto otherEntity : view) {
-            if (entity != otherEntity) {
-                auto &otherSphere{view.get<Sphere>(otherEntity)};
-                if (!shouldCheckCollision(sphere, otherSphere))
-                    if (SphereSphere(sphere, otherSphere)) {
-                        QString entity1{view.get<EInfo>(entity).name};
-                        QString entity2{view.get<EInfo>(otherEntity).name};
-
-                        collisions++;
-                        // notify FSM if needed
-                    }
-            }
+        const Sphere &sphere{view.get(entity)};
+        // Spheres on layers that don't collide with any of the others are left out of the sweep
+        if (!canReach(sphere, sphereLayers))
+            continue;
+        const BVH::Bounds bounds{colliderBounds(sphere)};
+        mSweep.update(Entity::index(entity), bounds.min, bounds.max);
+    }
+    mSweep.forEachPair([&](GLuint item, GLuint otherItem) {
+        const auto &sphere{view.get(registry->handle(item))};
+        const auto &otherSphere{view.get(registry->handle(otherItem))};
+        if (shouldCheckCollision(sphere, otherSphere) && SphereSphere(sphere, otherSphere)) {
+            collisions++;
+            // notify FSM if needed
+        }
+    });
+}
+void CollisionSystem::rayAABB(Raycast &ray, int ignoredEntity, GLuint layers)
+{
+    raycast(ray, AABBs, ignoredEntity, layers);
+}
+void CollisionSystem::raySphere(Raycast &ray, int ignoredEntity, GLuint layers)
+{
+    raycast(ray, Spheres, ignoredEntity, layers);
+}
+bool CollisionSystem::raycast(Raycast &raycast, int targets, int ignoredEntity, GLuint layers)
+{
+    bool hit{false};
+    castRay(raycast, targets, ignoredEntity, layers, [&](GLuint entity, float &maxDistance) {
+        if (raycast.intersectionDistance < raycast.closestTarget) {
+            raycast.closestTarget = raycast.intersectionDistance;
+            raycast.hitEntity = entity;
+            maxDistance = static_cast<float>(raycast.closestTarget);
+            hit = true;
         }
+        return true;
+    });
+    if (hit)
+        raycast.hitPoint = getPointOnRay(raycast, raycast.closestTarget);
+    return hit;
+}
+bool CollisionSystem::raycastAny(Raycast &raycast, int targets, int ignoredEntity, GLuint layers)
+{
+    bool hit{false};
+    castRay(raycast, targets, ignoredEntity, layers, [&](GLuint entity, float &) {
+        if (raycast.intersectionDistance >= raycast.closestTarget)
+            return true;
+        raycast.closestTarget = raycast.intersectionDistance;
+        raycast.hitEntity = entity;
+        raycast.hitPoint = getPointOnRay(raycast, raycast.closestTarget);
+        hit = true;
+        return false;
+    });
+    return hit;
+}
+std::vector<RayHit> CollisionSystem::raycastAll(const Raycast &raycast, int targets, int ignoredEntity, GLuint layers)
+{
+    std::vector<RayHit> hits;
+    Raycast ray{raycast};
+    castRay(ray, targets, ignoredEntity, layers, [&](GLuint entity, float &) {
+        if (ray.intersectionDistance < ray.rayRange)
+            hits.push_back(RayHit{entity, ray.intersectionDistance, getPointOnRay(ray, ray.intersectionDistance)});
+        return true;
+    });
+    std::sort(hits.begin(), hits.end(), [](const RayHit &lhs, const RayHit &rhs) { return lhs.distance < rhs.distance; });
+    return hits;
+}
+template <typename Func>
+void CollisionSystem::castRay(Raycast &raycast, int targets, int ignoredEntity, GLuint layers, Func onHit)
+{
+    const Ray &ray{raycast.ray};
+    const GLfloat origin[3]{ray.origin.x, ray.origin.y, ray.origin.z};
+    const GLfloat invDir[3]{ray.invDir.x, ray.invDir.y, ray.invDir.z};
+    // Carried over from one tree to the next, so a hit in the static tree also cuts the search of the dynamic one short
+    float reach{raycast.rayRange};
+    bool searching{true};
+    for (const ColliderTree *colliders : {&mStaticColliders, &mDynamicColliders}) {
+        const PackedColliders &packed{colliders->packed};
+        colliders->tree.raycastLeaves(ray.origin, ray.invDir, reach, [&](GLuint first, GLuint count, float &maxDistance) {
+            // Slab test against every box in the leaf at once
+            mDistances.resize(count);
+            const GLfloat *const min[3]{packed.min[0].data() + first, packed.min[1].data() + first, packed.min[2].data() + first};
+            const GLfloat *const max[3]{packed.max[0].data() + first, packed.max[1].data() + first, packed.max[2].data() + first};
+            gsl::simd::rayBoxes(count, min, max, origin, invDir, mDistances.data());
+            for (GLuint i{0}; i < count; i++) {
+                const GLuint item{first + i};
+                if (std::isinf(mDistances[i]) || !(packed.layers[item] & layers))
+                    continue;
+                const auto [entity, type]{colliders->colliders[item]};
+                if (!(type & targets) || static_cast<int>(entity) == ignoredEntity)
+                    continue;
+                // The trees are only updated once per frame, so the collider may have been removed since
+                if (type == AABBs) {
+                    if (!registry->contains<AABB>(entity))
+                        continue;
+                    raycast.intersectionDistance = mDistances[i];
+                }
+                else {
+                    // Only the sphere's bounding box was hit so far
+                    const vec3 center{packed.center[0][item], packed.center[1][item], packed.center[2][item]};
+                    if (!registry->contains<Sphere>(entity) || !calcRayToSphere(raycast, center, packed.radius[item]))
+                        continue;
+                }
+                searching = onHit(entity, maxDistance);
+                reach = maxDistance;
+                if (!searching)
+                    return false;
+            }
+            return true;
+        });
+        if (!searching)
+            return;
     }
 }
-void CollisionSystem::rayAABB(Raycast &ray, int ignoredEntity)
+void CollisionSystem::updateColliderTree()
 {
-    auto view{registry->view<AABB>()};
-    for (auto entity : view) {
-        if ((int)entity == ignoredEntity)
-            continue;
-        auto &aabb{view.get(entity)};
-        if (calcRayToAABB(ray, aabb)) {
-            if (ray.intersectionDistance < ray.closestTarget) {
-                ray.closestTarget = ray.intersectionDistance;
-                ray.hitEntity = entity;
+    auto aabbView{registry->view<AABB>()};
+    auto sphereView{registry->view<Sphere>()};
+    // The static tree is only built again when baking, or when one of its colliders was removed, moved or made dynamic.
+    // Such a collider is left out, and goes in the dynamic tree instead.
+    const bool staticChanged{mStaticChanged.exchange(false)};
+    if (mBakeStatic || staticChanged) {
+        std::vector<std::pair<GLuint, RayTargets>> members;
+        if (mBakeStatic) {
+            for (auto entity : aabbView) {
+                if (aabbView.get(entity).isStatic)
+                    members.emplace_back(entity, AABBs);
+            }
+            for (auto entity : sphereView) {
+                if (sphereView.get(entity).isStatic)
+                    members.emplace_back(entity, Spheres);
+            }
+        }
+        else {
+            for (const auto &[entity, type] : mStaticColliders.colliders) {
+                const Collision *collider{findCollider(entity, type)};
+                if (collider && collider->isStatic && !collider->transform.boundsOutdated)
+                    members.emplace_back(entity, type);
             }
         }
+        mStaticKeys.clear();
+        for (const auto &[entity, type] : members)
+            mStaticKeys.insert(colliderKey(entity, type));
+        rebuildColliderTree(mStaticColliders, std::move(members));
+        mBakeStatic = false;
     }
+    for (GLuint entity : mStaticInserts) {
+        for (RayTargets type : {AABBs, Spheres}) {
+            const Collision *collider{findCollider(entity, type)};
+            if (collider && collider->isStatic && mStaticKeys.insert(colliderKey(entity, type)).second)
+                insertCollider(mStaticColliders, entity, type);
+        }
+    }
+    mStaticInserts.clear();
+
+    // As many dynamic colliders as before, and every old one still there, means none were added or removed
+    const size_t dynamicCount{aabbView.size() + sphereView.size() - mStaticColliders.colliders.size()};
+    bool changed{dynamicCount != mDynamicColliders.colliders.size()};
+    for (size_t i{0}; !changed && i < mDynamicColliders.colliders.size(); i++) {
+        const auto [entity, type]{mDynamicColliders.colliders[i]};
+        changed = type == AABBs ? !aabbView.contains(entity) : !sphereView.contains(entity);
+    }
+    if (changed) {
+        std::vector<std::pair<GLuint, RayTargets>> members;
+        for (auto entity : aabbView) {
+            if (!mStaticKeys.count(colliderKey(entity, AABBs)))
+                members.emplace_back(entity, AABBs);
+        }
+        for (auto entity : sphereView) {
+            if (!mStaticKeys.count(colliderKey(entity, Spheres)))
+                members.emplace_back(entity, Spheres);
+        }
+        rebuildColliderTree(mDynamicColliders, std::move(members));
+        return;
+    }
+    bool moved{false};
+    for (GLuint i{0}; i < mDynamicColliders.colliders.size(); i++) {
+        const auto [entity, type]{mDynamicColliders.colliders[i]};
+        ColliderTransform &transform{type == AABBs ? aabbView.get(entity).transform : sphereView.get(entity).transform};
+        if (!transform.boundsOutdated)
+            continue;
+        const BVH::Bounds bounds{type == AABBs ? colliderBounds(aabbView.get(entity)) : colliderBounds(sphereView.get(entity))};
+        mDynamicColliders.tree.setBounds(i, bounds.min, bounds.max);
+        if (type == AABBs)
+            mDynamicColliders.packed.set(i, bounds, 0.f, aabbView.get(entity).layer);
+        else
+            mDynamicColliders.packed.set(i, bounds, sphereView.get(entity).radius, sphereView.get(entity).layer);
+        transform.boundsOutdated = false;
+        moved = true;
+    }
+    if (moved && !mDynamicColliders.tree.refit())
+        rebuildColliderTree(mDynamicColliders, std::move(mDynamicColliders.colliders));
 }
-void CollisionSystem::raySphere(Raycast &ray, int ignoredEntity)
+void CollisionSystem::rebuildColliderTree(ColliderTree &colliders, std::vector<std::pair<GLuint, RayTargets>> members)
 {
-    auto view{registry->view<Sphere>()};
-    for (auto entity : view) {
-        if ((int)entity == ignoredEntity)
-            continue;
-        auto &sphere{view.get(entity)};
-        if (calcRayToSphere(ray, sphere)) {
-            if (ray.intersectionDistance < ray.closestTarget) {
-                ray.closestTarget = ray.intersectionDistance;
-                ray.hitEntity = entity;
-            }
+    std::vector<BVH::Bounds> bounds;
+    bounds.reserve(members.size());
+    for (const auto &[entity, type] : members) {
+        if (type == AABBs) {
+            auto &aabb{registry->get<AABB>(entity)};
+            bounds.push_back(colliderBounds(aabb));
+            aabb.transform.boundsOutdated = false;
         }
+        else {
+            auto &sphere{registry->get<Sphere>(entity)};
+            bounds.push_back(colliderBounds(sphere));
+            sphere.transform.boundsOutdated = false;
+        }
+    }
+    colliders.tree.build(std::move(bounds));
+    // Put the colliders in the same order as the tree's items, so a leaf's colliders are next to each other in packed
+    colliders.colliders.clear();
+    colliders.colliders.reserve(members.size());
+    for (GLuint index : colliders.tree.order())
+        colliders.colliders.push_back(members[index]);
+    colliders.packed.resize(colliders.colliders.size());
+    for (GLuint i{0}; i < colliders.colliders.size(); i++) {
+        const auto [entity, type]{colliders.colliders[i]};
+        if (type == AABBs)
+            colliders.packed.set(i, colliders.tree.bounds(i), 0.f, registry->get<AABB>(entity).layer);
+        else
+            colliders.packed.set(i, colliders.tree.bounds(i), registry->get<Sphere>(entity).radius, registry->get<Sphere>(entity).layer);
     }
 }
+void CollisionSystem::insertCollider(ColliderTree &colliders, GLuint entity, RayTargets type)
+{
+    BVH::Bounds bounds;
+    float radius{0.f};
+    CollisionLayer layer;
+    if (type == AABBs) {
+        auto &aabb{registry->get<AABB>(entity)};
+        bounds = colliderBounds(aabb);
+        layer = aabb.layer;
+        aabb.transform.boundsOutdated = false;
+    }
+    else {
+        auto &sphere{registry->get<Sphere>(entity)};
+        bounds = colliderBounds(sphere);
+        radius = sphere.radius;
+        layer = sphere.layer;
+        sphere.transform.boundsOutdated = false;
+    }
+    const GLuint item{colliders.tree.insert(bounds.min, bounds.max)};
+    colliders.colliders.emplace_back(entity, type);
+    colliders.packed.resize(item + 1);
+    colliders.packed.set(item, bounds, radius, layer);
+}
+Collision *CollisionSystem::findCollider(GLuint entity, RayTargets type)
+{
+    if (type == AABBs)
+        return registry->contains<AABB>(entity) ? &registry->get<AABB>(entity) : nullptr;
+    return registry->contains<Sphere>(entity) ? &registry->get<Sphere>(entity) : nullptr;
+}
+void CollisionSystem::bakeStaticColliders()
+{
+    mBakeStatic = true;
+    mStaticInserts.clear();
+    // The entities in the old pairs are gone, and their IDs may be handed out again
+    mTowerRanges.clear();
+    mBulletHits.clear();
+}
+void CollisionSystem::insertStatic(GLuint entity)
+{
+    mStaticInserts.push_back(entity);
+}
+void CollisionSystem::staticColliderChanged(GLuint entity, RayTargets type)
+{
+    if (mStaticKeys.count(colliderKey(entity, type)))
+        mStaticChanged.store(true, std::memory_order_relaxed);
+}
+void CollisionSystem::onEntitiesRemoved(const std::vector<GLuint> &entities)
+{
+    for (GLuint entity : entities) {
+        staticColliderChanged(entity, AABBs);
+        staticColliderChanged(entity, Spheres);
+    }
+}
+void CollisionSystem::onComponentRemoved(GLuint entity, size_t componentType)
+{
+    if (componentType == ComponentFamily::type<AABB>)
+        staticColliderChanged(entity, AABBs);
+    else if (componentType == ComponentFamily::type<Sphere>)
+        staticColliderChanged(entity, Spheres);
+}
+void CollisionSystem::PackedColliders::resize(size_t size)
+{
+    for (int axis{0}; axis < 3; axis++) {
+        min[axis].resize(size);
+        max[axis].resize(size);
+        center[axis].resize(size);
+    }
+    radius.resize(size);
+    layers.resize(size);
+}
+void CollisionSystem::PackedColliders::set(size_t index, const BVH::Bounds &bounds, float sphereRadius, CollisionLayer layer)
+{
+    for (int axis{0}; axis < 3; axis++) {
+        min[axis][index] = bounds.min[axis];
+        max[axis][index] = bounds.max[axis];
+        center[axis][index] = (bounds.min[axis] + bounds.max[axis]) * 0.5f;
+    }
+    radius[index] = sphereRadius;
+    layers[index] = layerBit(layer);
+}
+BVH::Bounds CollisionSystem::colliderBounds(const AABB &aabb)
+{
+    return BVH::Bounds{getMin(aabb), getMax(aabb)};
+}
+BVH::Bounds CollisionSystem::colliderBounds(const Sphere &sphere)
+{
+    return BVH::Bounds{sphere.transform.worldMin, sphere.transform.worldMax};
+}
 
-Raycast CollisionSystem::mousePick(const QPoint &mousePos, const QRect &rect, int ignoredEntity, float range)
+Raycast CollisionSystem::mousePick(const QPoint &mousePos, const QRect &rect, int ignoredEntity, float range, GLuint layers)
 {
     Raycast raycast{range};
     raycast.ray = getRayFromMouse(mousePos, rect);
 
-    rayAABB(raycast, ignoredEntity);
+    rayAABB(raycast, ignoredEntity, layers);
     //    raySphere(raycast, ignoredEntity); // we probably don't care about sphere mouse picking.
     raycast.hitPoint = getPointOnRay(raycast, raycast.closestTarget);
 
@@ -160,29 +502,103 @@ Ray CollisionSystem::getRayFromMouse(const QPoint &mousePos, const QRect &rect)
 }
 inline bool CollisionSystem::shouldCheckCollision(const Collision &lhs, const Collision &rhs)
 {
-    return lhs.isStatic != rhs.isStatic || (!lhs.isStatic && !rhs.isStatic);
+    return (lhs.isStatic != rhs.isStatic || (!lhs.isStatic && !rhs.isStatic)) &&
+           (lhs.mask & layerBit(rhs.layer)) && (rhs.mask & layerBit(lhs.layer)) &&
+           layersCollide(lhs.layer, rhs.layer);
+}
+inline bool CollisionSystem::canReach(const Collision &collider, GLuint layers) const
+{
+    return mLayerMatrix[static_cast<size_t>(collider.layer)] & collider.mask & layers;
+}
+void CollisionSystem::setLayersCollide(CollisionLayer layer, CollisionLayer other, bool collide)
+{
+    GLuint &row{mLayerMatrix[static_cast<size_t>(layer)]}, &otherRow{mLayerMatrix[static_cast<size_t>(other)]};
+    if (collide) {
+        row |= layerBit(other);
+        otherRow |= layerBit(layer);
+    }
+    else {
+        row &= ~layerBit(other);
+        otherRow &= ~layerBit(layer);
+    }
+}
+bool CollisionSystem::layersCollide(CollisionLayer layer, CollisionLayer other) const
+{
+    return mLayerMatrix[static_cast<size_t>(layer)] & layerBit(other);
 }
 
 gsl::Vector3D CollisionSystem::getMin(const AABB &aabb)
 {
-    vec3 origin{aabb.transform.modelMatrix.getPosition()};
-    vec3 p1{origin + aabb.size};
-    vec3 p2{origin - aabb.size};
-
-    return vec3{fminf(p1.x, p2.x),
-                fminf(p1.y, p2.y),
-                fminf(p1.z, p2.z)};
+    return aabb.transform.worldMin;
 }
 
 gsl::Vector3D CollisionSystem::getMax(const AABB &aabb)
 {
-    vec3 origin{aabb.transform.modelMatrix.getPosition()};
-    vec3 p1{origin + aabb.size};
-    vec3 p2{origin - aabb.size};
-
-    return vec3{fmaxf(p1.x, p2.x),
-                fmaxf(p1.y, p2.y),
-                fmaxf(p1.z, p2.z)};
+    return aabb.transform.worldMax;
+}
+gsl::Vector3D CollisionSystem::sphereReach(const Sphere &sphere)
+{
+    return vec3{sphere.radius, sphere.radius, sphere.radius};
+}
+float CollisionSystem::sphereHitDistanceSq(const Sphere &sphere)
+{
+    return sphere.radius * sphere.radius;
+}
+bool CollisionSystem::sweptSphereAABB(const vec3 &start, const vec3 &end, float radius, const vec3 &boxMin, const vec3 &boxMax, float &time)
+{
+    // The sphere can only touch the box while its centre is inside the box grown by the radius, so clip the path to that first
+    const vec3 path{end - start};
+    float enter{0.f}, exit{1.f};
+    for (int axis{0}; axis < 3; axis++) {
+        const float low{boxMin[axis] - radius}, high{boxMax[axis] + radius};
+        if (path[axis] == 0.f) {
+            if (start[axis] < low || start[axis] > high)
+                return false;
+            continue;
+        }
+        float t1{(low - start[axis]) / path[axis]};
+        float t2{(high - start[axis]) / path[axis]};
+        if (t1 > t2)
+            std::swap(t1, t2);
+        enter = std::max(enter, t1);
+        exit = std::min(exit, t2);
+        if (enter > exit)
+            return false;
+    }
+    // The grown box has rounded edges and corners, which the path can still miss.
+    // The distance to the box is convex along the path, so Newton steps towards the contact never step past it,
+    // and once the distance stops shrinking the sphere is moving away for good.
+    float t{enter};
+    for (int step{0}; step < MaxSweepSteps; step++) {
+        const vec3 center{start + path * t};
+        const vec3 closest{std::clamp(center.x, boxMin.x, boxMax.x), std::clamp(center.y, boxMin.y, boxMax.y), std::clamp(center.z, boxMin.z, boxMax.z)};
+        const vec3 offset{center - closest};
+        const float distance{offset.length()};
+        const float gap{distance - radius};
+        if (gap <= SweepTolerance) {
+            time = t;
+            return true;
+        }
+        const float approach{-vec3::dot(offset, path) / distance};
+        if (approach <= 0.f)
+            return false;
+        t += gap / approach;
+        if (t > exit)
+            return false;
+    }
+    return false;
+}
+const PairCache &CollisionSystem::towerRanges() const
+{
+    return mTowerRanges;
+}
+void CollisionSystem::setCellSize(float size)
+{
+    mGrid.setCellSize(size);
+}
+float CollisionSystem::cellSize() const
+{
+    return mGrid.cellSize();
 }
 bool CollisionSystem::SphereSphere(const Sphere &sphere1, const Sphere &sphere2)
 {
@@ -191,9 +607,10 @@ bool CollisionSystem::SphereSphere(const Sphere &sphere1, const Sphere &sphere2)
     // sum of radius
     float rs{sphere1.radius + sphere2.radius};
     // dist squared
-    float dist{(sphere1Pos + sphere2Pos).length()};
+    vec3 offset{sphere1Pos - sphere2Pos};
+    float distSq{vec3::dot(offset, offset)};
     // compare
-    return dist < (rs * rs);
+    return distSq < (rs * rs);
 }
 bool CollisionSystem::SphereAABB(const Sphere &sphere, const AABB &aabb)
 {
@@ -204,10 +621,10 @@ bool CollisionSystem::SphereAABB(const Sphere &sphere, const AABB &aabb)
     // Now sends the center position of the sphere
     vec3 closestPoint{ClosestPoint(aabb, spherePos)};
 
-    float dist{(spherePos - closestPoint).length()};
-    float radiusSq{sphere.radius * sphere.radius};
+    vec3 offset{spherePos - closestPoint};
+    float distSq{vec3::dot(offset, offset)};
 
-    return dist < radiusSq;
+    return distSq < sphere.radius * sphere.radius;
 }
 
 bool CollisionSystem::AABBAABB(const AABB &AABB1, const AABB &AABB2)
@@ -251,12 +668,16 @@ gsl::Vector3D CollisionSystem::ClosestPoint(const Sphere &sphere, const vec3 &po
 }
 bool CollisionSystem::calcRayToSphere(Raycast &r, const Sphere &sphere)
 {
-    vec3 center{sphere.transform.modelMatrix.getPosition() + sphere.position};
+    // The model matrix already includes the collider's offset
+    return calcRayToSphere(r, sphere.transform.modelMatrix.getPosition(), sphere.radius);
+}
+bool CollisionSystem::calcRayToSphere(Raycast &r, const vec3 &center, float radius)
+{
     vec3 originToCenter{r.ray.origin - center};
 
     float a{vec3::dot(r.ray.direction, r.ray.direction)};
     float b{2.f * vec3::dot(originToCenter, r.ray.direction)};
-    float c{vec3::dot(originToCenter, originToCenter) - (sphere.radius * sphere.radius)};
+    float c{vec3::dot(originToCenter, originToCenter) - (radius * radius)};
     float discriminant{(b * b) - (4 * a * c)};
     if (discriminant < 0)
         return false;
@@ -394,10 +815,33 @@ void CollisionSystem::setObjectType(int index)
     if (registry->contains<AABB>(entityID)) {
         auto &aabb{registry->get<AABB>(entityID)};
         aabb.isStatic = isStatic;
+        if (!isStatic)
+            staticColliderChanged(entityID, AABBs);
         return;
     }
     if (registry->contains<Sphere>(entityID)) {
         auto &sphere{registry->get<Sphere>(entityID)};
         sphere.isStatic = isStatic;
+        if (!isStatic)
+            staticColliderChanged(entityID, Spheres);
+    }
+}
+void CollisionSystem::setCollisionLayer(int index)
+{
+    if (index < 0 || index >= static_cast<int>(CollisionLayer::COUNT))
+        return;
+    CollisionLayer layer{static_cast<CollisionLayer>(index)};
+    GLuint entityID{registry->getSelectedEntity()};
+    // The collider tree keeps a copy of the layer, which is updated along with the bounds
+    if (registry->contains<AABB>(entityID)) {
+        auto &aabb{registry->get<AABB>(entityID)};
+        aabb.layer = layer;
+        aabb.transform.boundsOutdated = true;
+        return;
+    }
+    if (registry->contains<Sphere>(entityID)) {
+        auto &sphere{registry->get<Sphere>(entityID)};
+        sphere.layer = layer;
+        sphere.transform.boundsOutdated = true;
     }
 }
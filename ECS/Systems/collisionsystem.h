@@ -1,10 +1,16 @@
 #ifndef COLLISIONSYSTEM_H
 #define COLLISIONSYSTEM_H
 
+#include "bvh.h"
 #include "components.h"
 #include "deltaTime.h"
 #include "isystem.h"
+#include "paircache.h"
+#include "spatialgrid.h"
+#include "sweepandprune.h"
 #include <QOpenGLFunctions_4_1_Core>
+#include <atomic>
+#include <unordered_set>
 /**
  * @brief The Ray struct is a simple representation of a ray from point A to point B.
  */
@@ -38,6 +44,14 @@ struct Raycast {
     int hitEntity{-1};
     gsl::Vector3D hitPoint;
 };
+/**
+ * @brief The RayHit struct is one of the colliders found by CollisionSystem::raycastAll.
+ */
+struct RayHit {
+    GLuint entity;
+    double distance;
+    gsl::Vector3D hitPoint;
+};
 class Registry;
 /**
  * @brief The CollisionSystem class performs collision detection/response for AABB and Sphere colliders.
@@ -47,9 +61,21 @@ class CollisionSystem : public QObject, public ISystem, public QOpenGLFunctions_
     using vec3 = gsl::Vector3D;
 
 public:
+    /**
+     * @brief Collider types a raycast can hit, can be combined.
+     */
+    enum RayTargets {
+        AABBs = 1,
+        Spheres = 2,
+        AllColliders = AABBs | Spheres
+    };
     CollisionSystem();
 
     void update(DeltaTime dt = 0.016) override;
+    /**
+     * @brief Runs the collision simulations, once per fixed tick.
+     * @param dt
+     */
     void updatePlayOnly(DeltaTime dt = 0.016);
 
     /**
@@ -58,9 +84,81 @@ public:
      * @param rect
      * @param ignoredEntity Can be supplied to force the function to ignore a certain entity, such as the object being dragged in InputSystem's dragEntity()
      * @param range
+     * @param layers layerBit()s of the colliders that can be picked
+     * @return
+     */
+    Raycast mousePick(const QPoint &mousePos, const QRect &rect, int ignoredEntity = -1, float range = 250.f, GLuint layers = AllLayers);
+    /**
+     * @brief Finds the closest collider hit by the ray within its range, filling in hitEntity, closestTarget and hitPoint.
+     * @param raycast
+     * @param targets RayTargets to test against
+     * @param ignoredEntity
+     * @param layers layerBit()s of the colliders to test against
+     * @return true if anything was hit
+     */
+    bool raycast(Raycast &raycast, int targets = AllColliders, int ignoredEntity = -1, GLuint layers = AllLayers);
+    /**
+     * @brief Stops at the first collider found within the ray's range, which isn't necessarily the closest one.
+     * Cheaper than raycast() when all that matters is whether something is in the way.
+     * @param raycast
+     * @param targets RayTargets to test against
+     * @param ignoredEntity
+     * @param layers layerBit()s of the colliders to test against
+     * @return true if anything was hit
+     */
+    bool raycastAny(Raycast &raycast, int targets = AllColliders, int ignoredEntity = -1, GLuint layers = AllLayers);
+    /**
+     * @brief Finds every collider hit by the ray within its range.
+     * @param raycast
+     * @param targets RayTargets to test against
+     * @param ignoredEntity
+     * @param layers layerBit()s of the colliders to test against
+     * @return the hits, closest first
+     */
+    std::vector<RayHit> raycastAll(const Raycast &raycast, int targets = AllColliders, int ignoredEntity = -1, GLuint layers = AllLayers);
+    /**
+     * @brief Towers and the enemies in their range, as (tower, enemy) pairs, with the events of the last collision tick.
+     * Only colliders with overlapEvent set are tracked.
      * @return
      */
-    Raycast mousePick(const QPoint &mousePos, const QRect &rect, int ignoredEntity = -1, float range = 250.f);
+    const PairCache &towerRanges() const;
+    /**
+     * @brief Size of the broadphase grid's cells, set per level and saved with the scene.
+     * @param size
+     */
+    void setCellSize(float size);
+    float cellSize() const;
+    /**
+     * @brief Set whether colliders on the two layers are tested against each other, the layer matrix being symmetric.
+     * Every layer collides with every other by default, except for the ones set up in the constructor.
+     * Checked in the broadphase, so whole layers that don't collide with anything are never tested at all.
+     * @param layer
+     * @param other
+     * @param collide
+     */
+    void setLayersCollide(CollisionLayer layer, CollisionLayer other, bool collide);
+    bool layersCollide(CollisionLayer layer, CollisionLayer other) const;
+    /**
+     * @brief Builds the static collider tree again from every static collider at the next update, e.g. after loading a scene.
+     * The ray queries search it separately from the dynamic tree, which holds every other collider and is refit as they move.
+     * A static collider that moves, is removed or is made dynamic leaves the static tree until the next bake.
+     * Also forgets the overlapping pairs, since a new scene or the end of play mode leaves none of them.
+     */
+    void bakeStaticColliders();
+    /**
+     * @brief Adds an entity's static colliders to the static collider tree at the next update, without building it again.
+     * For colliders that just stopped moving for good, like a tower that's been placed.
+     * @param entity
+     */
+    void insertStatic(GLuint entity);
+    /**
+     * @brief Called when a collider moved, was removed or was made dynamic. If it's in the static collider tree,
+     * the tree is built again without it at the next update.
+     * Only reads the tree, so MovementSystem can call it from several threads at once.
+     * @param entity
+     * @param type either AABBs or Spheres
+     */
+    void staticColliderChanged(GLuint entity, RayTargets type);
 public slots:
     void setOriginX(double xIn);
     void setOriginY(double xIn);
@@ -73,12 +171,138 @@ public slots:
     void setSpherePositionZ(double zIn);
     void setSphereRadius(double radius);
     void setObjectType(int index);
+    void setCollisionLayer(int index);
 
 private:
-    float fixedDelta{0.02f};
-    float delta{0};
     int collisions{0};
     Registry *registry;
+    /// Broadphase for the play-mode simulations, rebuilt from the enemies' bounds every tick
+    SpatialGrid mGrid;
+    /// Enemies in the grid, indexed by their grid item
+    std::vector<GLuint> mEnemies;
+    /// (tower, enemy) pairs, see towerRanges()
+    PairCache mTowerRanges;
+    /// (bullet, enemy) pairs, bullets do their damage when they enter
+    PairCache mBulletHits;
+    /// Broadphase for sphere against sphere, by entity index
+    SweepAndPrune mSweep;
+    /// Indexed by layer, the layerBit()s of the layers it collides with
+    std::array<GLuint, static_cast<size_t>(CollisionLayer::COUNT)> mLayerMatrix;
+    /**
+     * @brief World space bounds of the colliders in a collider tree, in the tree's order, one array per coordinate for the gsl::simd kernels.
+     * Spheres also keep their centre and radius, boxes have a radius of 0.
+     * The layers are kept as layerBit()s, to be checked against the layer mask of the ray.
+     */
+    struct PackedColliders {
+        std::array<std::vector<GLfloat>, 3> min, max, center;
+        std::vector<GLfloat> radius;
+        std::vector<GLuint> layers;
+
+        void resize(size_t size);
+        void set(size_t index, const BVH::Bounds &bounds, float sphereRadius, CollisionLayer layer);
+    };
+    /**
+     * @brief A tree of AABB and Sphere colliders for the ray queries, along with the owner, type and packed bounds of each of its items.
+     */
+    struct ColliderTree {
+        BVH tree;
+        std::vector<std::pair<GLuint, RayTargets>> colliders;
+        PackedColliders packed;
+    };
+    /// Colliders that don't move, only built when baking and added to when placing things
+    ColliderTree mStaticColliders;
+    /// Every collider not in mStaticColliders, refit every frame
+    ColliderTree mDynamicColliders;
+    /// Entity and type of every collider in mStaticColliders, see colliderKey()
+    std::unordered_set<std::uint64_t> mStaticKeys;
+    bool mBakeStatic{true};
+    /// Set when a collider in mStaticColliders moved, was removed or was made dynamic, see staticColliderChanged()
+    std::atomic<bool> mStaticChanged{false};
+    /// Entities whose static colliders are inserted into mStaticColliders at the next update
+    std::vector<GLuint> mStaticInserts;
+    /// Results of the gsl::simd kernels, kept to reuse the memory
+    std::vector<GLfloat> mDistances;
+    /**
+     * @brief Registry::entitiesRemoved handler, the static tree can't keep the colliders of destroyed entities.
+     * @param entities
+     */
+    void onEntitiesRemoved(const std::vector<GLuint> &entities);
+    /**
+     * @brief Registry::componentRemoved handler, the static tree can't keep a collider that was removed.
+     * @param entity
+     * @param componentType
+     */
+    void onComponentRemoved(GLuint entity, size_t componentType);
+    /**
+     * @brief Keep the static and dynamic collider trees up to date.
+     * The static tree is only built when baking or when one of its colliders changed, and added to by insertStatic().
+     * The dynamic tree is refit to the colliders that moved since the last frame, or rebuilt if colliders were added or removed.
+     */
+    void updateColliderTree();
+    /**
+     * @brief Build a collider tree from scratch.
+     * @param colliders
+     * @param members owner and type of every collider to put in it
+     */
+    void rebuildColliderTree(ColliderTree &colliders, std::vector<std::pair<GLuint, RayTargets>> members);
+    /**
+     * @brief Adds one collider to a collider tree, see BVH::insert().
+     * @param colliders
+     * @param entity
+     * @param type
+     */
+    void insertCollider(ColliderTree &colliders, GLuint entity, RayTargets type);
+    /**
+     * @brief Gets a collider of an entity.
+     * @param entity
+     * @param type either AABBs or Spheres
+     * @return nullptr if the entity doesn't have one
+     */
+    Collision *findCollider(GLuint entity, RayTargets type);
+    static std::uint64_t colliderKey(GLuint entity, RayTargets type)
+    {
+        return static_cast<std::uint64_t>(entity) << 2 | static_cast<std::uint64_t>(type);
+    }
+    /**
+     * @brief Runs the narrow phase on every collider the ray might hit according to the static and dynamic collider trees.
+     * @param raycast
+     * @param targets
+     * @param ignoredEntity
+     * @param layers
+     * @param onHit called as onHit(entity, maxDistance) for each hit, with raycast.intersectionDistance set.
+     * Lowering maxDistance skips colliders further away, returning false ends the search.
+     */
+    template <typename Func>
+    void castRay(Raycast &raycast, int targets, int ignoredEntity, GLuint layers, Func onHit);
+    BVH::Bounds colliderBounds(const AABB &aabb);
+    BVH::Bounds colliderBounds(const Sphere &sphere);
+    /**
+     * @brief Half size of the box around a sphere that SphereAABB() can report hits in, used to query the grid.
+     * @param sphere
+     * @return
+     */
+    static vec3 sphereReach(const Sphere &sphere);
+    /**
+     * @brief Squared distance from a sphere's centre to a box below which SphereAABB() reports a hit, for the gsl::simd::boxDistancesSq() results.
+     * @param sphere
+     * @return
+     */
+    static float sphereHitDistanceSq(const Sphere &sphere);
+    /// Most steps sweptSphereAABB() takes towards the rounded corners of a box before calling it a miss
+    static constexpr int MaxSweepSteps{16};
+    /// How close sweptSphereAABB() has to get to count as touching
+    static constexpr float SweepTolerance{1e-4f};
+    /**
+     * @brief Time of impact of a sphere moving in a straight line against an AABB.
+     * @param start centre of the sphere at the start of the move
+     * @param end centre of the sphere at the end of the move
+     * @param radius
+     * @param boxMin
+     * @param boxMax
+     * @param time how far along the move the sphere first touches the box, from 0 to 1
+     * @return true if the sphere touches the box anywhere along the move
+     */
+    static bool sweptSphereAABB(const vec3 &start, const vec3 &end, float radius, const vec3 &boxMin, const vec3 &boxMax, float &time);
     /**
      * @brief Runs the collision simulations for AABB types.
      */
@@ -90,27 +314,29 @@ private:
     /**
     * @brief Helper function getMin finds minimum point in an AABB.
     * @param aabb
-    * @return a vector minimum point found in the AABB
+    * @return a vector minimum point found in the AABB, cached since the collider last moved
     */
     vec3 getMin(const AABB &aabb);
     /**
     * @brief Helper function getMax finds maximum point in an AABB.
     * @param aabb
-    * @return a vector maximum point found in the AABB
+    * @return a vector maximum point found in the AABB, cached since the collider last moved
     */
     vec3 getMax(const AABB &aabb);
     /**
-     * @brief Checks every entity owning an AABB collider to find the closest one hit by the ray.
+     * @brief Finds the closest AABB collider hit by the ray.
      * @param ray
      * @param ignoredEntity
+     * @param layers
      */
-    void rayAABB(Raycast &ray, int ignoredEntity = -1);
+    void rayAABB(Raycast &ray, int ignoredEntity = -1, GLuint layers = AllLayers);
     /**
-     * @brief Checks every entity owning a Sphere collider to find the closest one hit by the ray.
+     * @brief Finds the closest Sphere collider hit by the ray.
      * @param ray
      * @param ignoredEntity
+     * @param layers
      */
-    void raySphere(Raycast &ray, int ignoredEntity = -1);
+    void raySphere(Raycast &ray, int ignoredEntity = -1, GLuint layers = AllLayers);
 
     void rayPlane(Raycast &ray, int ignoredEntity = -1);
 
@@ -133,21 +359,27 @@ private:
     * @brief Collision between two spheres.
     * @param sphere1
     * @param sphere2
-    * @return true if distance is less than radius^2 (intersection)
+    * @return true if the distance between them is less than the sum of their radii (intersection)
     */
     bool SphereSphere(const Sphere &sphere1, const Sphere &sphere2);
     /**
      * @brief Finds the intersection point between a ray and a sphere collider.
-     * Not to be confused with raySphere which runs this function for each entity.
+     * Not to be confused with raySphere which runs this function for each sphere the ray might hit.
      * @param ray
      * @param sphere
      * @param intersectionDistance retrieves the distance between the ray origin and the sphere
      * @return true if hit, false if not
      */
     bool calcRayToSphere(Raycast &r, const Sphere &sphere);
+    /**
+     * @copydoc CollisionSystem::calcRayToSphere(Raycast &, const Sphere &)
+     * @param center world position of the sphere
+     * @param radius
+     */
+    bool calcRayToSphere(Raycast &r, const vec3 &center, float radius);
     /**
      * @brief Finds the intersection point between ray and AABB collider.
-     * Not to be confused with rayAABB which runs this function for each entity.
+     * Not to be confused with rayAABB which runs this function for each AABB the ray might hit.
      * @param r
      * @param aabb
      * @param intersectionDistance retrieves the distance between ray origin and AABB
@@ -185,12 +417,20 @@ private:
     // todo
     //    vec3 ClosestPoint(const OBB &obb, const vec3 &point);
     /**
-     * @brief Check if one or both of the colliders are set to dynamic object type.
+     * @brief Check if one or both of the colliders are set to dynamic object type,
+     * and that their layers collide according to both the layer matrix and their masks.
      * @param lhs
      * @param rhs
      * @return
      */
     bool shouldCheckCollision(const Collision &lhs, const Collision &rhs);
+    /**
+     * @brief Check if a collider could collide with anything on the given layers, to skip it before the broadphase.
+     * @param collider
+     * @param layers layerBit()s of every layer it could be tested against
+     * @return
+     */
+    bool canReach(const Collision &collider, GLuint layers) const;
 };
 
 #endif // COLLISIONSYSTEM_H
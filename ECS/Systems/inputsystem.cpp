@@ -15,6 +15,10 @@ InputSystem::InputSystem(RenderWindow *window, cjk::Ref<CameraController> editor
     : registry{Registry::instance()}, factory{ResourceManager::instance()},
       mRenderWindow{window}, mEditorCamController(editorController)
 {
+    addReads<GameCamera, Buildable, AABB, TowerComponent, Sphere>();
+    addWrites<Transform, Material, Buildable>();
+    mStructural = true; // Places and removes towers
+    mContextThread = true;
 }
 
 void InputSystem::update(DeltaTime dt)
@@ -249,7 +253,7 @@ void InputSystem::updateBuildable(GLuint entityID)
         trans.localScale.y = scaleY; // set local scale in y axis to be similar to a raised platform
         aabb.size.y = scaleY;        // update the AABB to keep up with mesh scale.
         trans.localPosition.y += scaleY;
-        trans.matrixOutdated = true;
+        registry->transforms().markDirty(entityID);
     }
     else {
         if (mIsDragging || mBuildableDebug) {
@@ -260,7 +264,7 @@ void InputSystem::updateBuildable(GLuint entityID)
         float nScale{0.01f};
         trans.localScale.y = nScale;
         aabb.size.y = nScale;
-        trans.matrixOutdated = true;
+        registry->transforms().markDirty(entityID);
     }
 }
 void InputSystem::placeTower()
@@ -277,13 +281,15 @@ void InputSystem::placeTower()
             build.isBuildable = false;
             tower.state = TowerStates::IDLE;
             sphere.overlapEvent = true;
+            sphere.isStatic = true; // Placed for good, so both colliders go in the static collider tree
             player.gold -= tower.towerCost;
             auto &planeTransform{view.get<Transform>(lastHitEntity)};
             float scaleY{planeTransform.localScale.y};
             vec3 topCenterOfTarget{planeTransform.localPosition};
             topCenterOfTarget.y += (aabb.size.y + scaleY); // place the tower just slightly above the Plane it's sitting on to avoid clipping.
             towerTransform.localPosition = topCenterOfTarget;
-            towerTransform.matrixOutdated = true;
+            registry->transforms().markDirty(draggedEntity);
+            registry->system<CollisionSystem>()->insertStatic(draggedEntity);
             setPlaneColors(mIsDragging);
         }
     }
@@ -299,7 +305,9 @@ void InputSystem::dragEntity(GLuint entity)
     // make ray
     auto collisionSystem{registry->system<CollisionSystem>()};
     // we pass the dragged entity to mousePick in order to ignore that entity in raycasting
-    Raycast ray{collisionSystem->mousePick(cursorPos, mRenderWindow->geometry(), entity, 100.f)};
+    // Towers are only placed on the ground, so enemies and other towers can't get in the way
+    const GLuint groundLayers{AllLayers & ~(layerBit(CollisionLayer::ENEMY) | layerBit(CollisionLayer::TOWER))};
+    Raycast ray{collisionSystem->mousePick(cursorPos, mRenderWindow->geometry(), entity, 100.f, groundLayers)};
     auto towerView{registry->view<Transform, TowerComponent>()};
     auto [tf, tower]{towerView.get<Transform, TowerComponent>(entity)};
     // some functionality might need to be added here for things like placing the entity in the center of a plane collider regardless of where on the collider the mouse is etc
@@ -330,7 +338,7 @@ void InputSystem::dragEntity(GLuint entity)
 
     // place the object either on the mouse at 100.f distance or at correct distance for the AABB hit
     tf.localPosition = ray.hitPoint;
-    tf.matrixOutdated = true;
+    registry->transforms().markDirty(entity);
 }
 
 std::vector<cjk::Ref<GameCameraController>> InputSystem::gameCameraControllers() const
@@ -2,15 +2,53 @@
 #define ISYSTEM_H
 
 #include "deltaTime.h"
+#include "family.h"
 #include <QObject>
 /**
  * @brief The ISystem class is a simple interface class for systems.
+ * Systems declare which component types they read and write in their constructor,
+ * which lets the Scheduler figure out which systems can safely run at the same time.
  */
 class ISystem {
 public:
     ISystem() {}
+    virtual ~ISystem() = default;
 
     virtual void update(DeltaTime deltaTime = 0.016) = 0;
+
+    /**
+     * Component types the system reads.
+     * @return
+     */
+    const Signature &reads() const { return mReads; }
+    /**
+     * Component types the system writes.
+     * @return
+     */
+    const Signature &writes() const { return mWrites; }
+    /**
+     * Whether the system has to run on the thread owning the OpenGL context.
+     * True for anything issuing GL calls or touching Qt objects.
+     * @return
+     */
+    bool contextThread() const { return mContextThread; }
+    /**
+     * Whether the system creates or destroys entities or components.
+     * Structural changes may reallocate any pool, so such systems never run alongside another system.
+     * @return
+     */
+    bool structural() const { return mStructural; }
+
+protected:
+    template <typename... Comp>
+    void addReads() { (mReads.set(ComponentFamily::type<Comp>), ...); }
+    template <typename... Comp>
+    void addWrites() { (mWrites.set(ComponentFamily::type<Comp>), ...); }
+
+    Signature mReads;
+    Signature mWrites;
+    bool mContextThread{false};
+    bool mStructural{false};
 };
 
 #endif // ISYSTEM_H
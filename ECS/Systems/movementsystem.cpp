@@ -1,183 +1,252 @@
 #include "movementsystem.h"
 #include "cameracontroller.h"
+#include "collisionsystem.h"
+#include "gsl_simd.h"
 #include "registry.h"
+#include <utility>
 
 MovementSystem::MovementSystem() : registry{Registry::instance()}
 {
+    addReads<Velocity, BillBoard, Material>();
+    addWrites<Transform, AABB, Sphere>();
 }
 void MovementSystem::init()
 {
     update();
 }
-void MovementSystem::update(DeltaTime dt)
+void MovementSystem::update(DeltaTime)
 {
-    auto view{registry->view<Transform>()};
-    for (auto entity : view) {
-        auto view{registry->view<Transform>()};
-        Transform &comp{view.get(entity)};
-        if (comp.matrixOutdated) {
-            updateColliders(entity);
-        }
-        updateModelMatrix(comp);
-    }
-
-    auto bulletview{registry->view<Transform, Bullet>()};
-    for (auto entity : bulletview) {
-        auto &bullet{bulletview.get<Bullet>(entity)};
-        vec3 deltaVector = bullet.direction * dt * bullet.speed;
-        move(entity, deltaVector);
+    // Billboards turn first, so their new rotations are composed in the same batch as everything else
+    auto billboardView{registry->view<BillBoard, Transform, Material>()};
+    for (auto entity : billboardView) {
+        auto [billboard, transform, mat]{billboardView.get<BillBoard, Transform, Material>(entity)};
+        updateBillBoardTransformPrivate(entity, billboard, transform, mat);
     }
+    updateHierarchy();
 
-    auto aabbview{registry->view<Transform, AABB>()};
-    for (auto entity : aabbview) {
-        auto [trans, col]{aabbview.get<Transform, AABB>(entity)};
-        if (col.transform.matrixOutdated) {
-            updateTS(col);
-            updateColliderTransformPrivate(col, trans);
+    // Colliders only read their owner's world matrix, so they can be updated in parallel.
+    // A static collider that moved has to leave the static collider tree.
+    CollisionSystem *collision{registry->system<CollisionSystem>().get()};
+    registry->view<Transform, AABB>().par_each([this, collision](GLuint entity, const Transform &, AABB &col) {
+        if (!col.transform.matrixOutdated)
+            return;
+        updateColliderTransformPrivate(col, entity, getTSMatrix(col), vec3{std::fabs(col.size.x), std::fabs(col.size.y), std::fabs(col.size.z)});
+        if (col.isStatic && collision)
+            collision->staticColliderChanged(entity, CollisionSystem::AABBs);
+    });
+    registry->view<Transform, Sphere>().par_each([this, collision](GLuint entity, const Transform &, Sphere &col) {
+        if (!col.transform.matrixOutdated)
+            return;
+        updateColliderTransformPrivate(col, entity, getTSMatrix(col), vec3{col.radius, col.radius, col.radius});
+        if (col.isStatic && collision)
+            collision->staticColliderChanged(entity, CollisionSystem::Spheres);
+    });
+}
+void MovementSystem::updateFixed(DeltaTime dt)
+{
+    registry->transforms().savePrevious();
+    integrate(dt);
+}
+void MovementSystem::integrate(DeltaTime dt)
+{
+    mMoving.clear();
+    mMovingTransforms.clear();
+    mPositions.clear();
+    mVelocities.clear();
+    registry->view<Transform, Velocity>().each([this](GLuint entity, Transform &transform, const Velocity &velocity) {
+        if (velocity.velocity == vec3{0})
+            return;
+        mMoving.push_back(entity);
+        mMovingTransforms.push_back(&transform);
+        for (int axis{0}; axis < 3; axis++) {
+            mPositions.push_back(transform.localPosition[axis]);
+            mVelocities.push_back(velocity.velocity[axis]);
         }
+    });
+    gsl::simd::addScaled(mPositions.size(), mVelocities.data(), dt, mPositions.data());
+    for (size_t i{0}; i < mMovingTransforms.size(); i++)
+        mMovingTransforms[i]->localPosition = vec3{mPositions[i * 3], mPositions[i * 3 + 1], mPositions[i * 3 + 2]};
+    registry->transforms().markDirty(mMoving);
+}
+void MovementSystem::setWorldMatrix(GLuint eID, Transform &comp, const gsl::Matrix4x4 &localTR, const gsl::Matrix4x4 &localTRS)
+{
+    auto &transforms{registry->transforms()};
+    if (comp.parentID != -1) {
+        const gsl::Matrix4x4 parentTR{transforms.worldTR(comp.parentID)};
+        gsl::Matrix4x4 &worldTR{transforms.worldTR(eID)};
+        worldTR = parentTR * localTR;
+        transforms.world(eID) = parentTR * localTRS;
+        // Cached here so getAbsolutePosition/Rotation don't need to touch the matrices
+        comp.position = worldTR.getPosition();
+        comp.orientation = registry->get<Transform>(comp.parentID).orientation * comp.localOrientation;
     }
-    auto sphereview{registry->view<Transform, Sphere>()};
-    for (auto entity : sphereview) {
-        auto [trans, col]{sphereview.get<Transform, Sphere>(entity)};
-        if (col.transform.matrixOutdated) {
-            updateTS(col);
-            updateColliderTransformPrivate(col, trans);
+    else {
+        transforms.worldTR(eID) = localTR;
+        transforms.world(eID) = localTRS;
+        comp.position = comp.localPosition;
+        comp.orientation = comp.localOrientation;
+    }
+}
+void MovementSystem::flagChildren(const Transform &comp)
+{
+    auto &transforms{registry->transforms()};
+    for (int child{comp.firstChild}; child != -1; child = registry->get<Transform>(child).nextSibling)
+        transforms.markDirty(child);
+}
+void MovementSystem::updateHierarchy()
+{
+    auto &transforms{registry->transforms()};
+    if (!transforms.anyDirty())
+        return;
+    if (transforms.orderOutdated())
+        sortHierarchy();
+    // Collect every outdated Transform, parents first.
+    // The children they flag as outdated come further along the order, so they end up in the same batch.
+    mBatch.clear();
+    for (auto &values : mBatchValues)
+        values.clear();
+    for (GLuint index : transforms.order()) {
+        if (!transforms.isDirty(index))
+            continue;
+        transforms.clearDirty(index);
+        const GLuint entity{registry->handle(index)};
+        if (entity == Entity::Null || !registry->contains<Transform>(entity))
+            continue;
+        const Transform &comp{registry->get<Transform>(entity)};
+        mBatch.push_back(entity);
+        for (int axis{0}; axis < 3; axis++) {
+            mBatchValues[axis].push_back(comp.localPosition[axis]);
+            mBatchValues[7 + axis].push_back(comp.localScale[axis]);
         }
+        mBatchValues[3].push_back(comp.localOrientation.x);
+        mBatchValues[4].push_back(comp.localOrientation.y);
+        mBatchValues[5].push_back(comp.localOrientation.z);
+        mBatchValues[6].push_back(comp.localOrientation.w);
+        flagChildren(comp);
     }
-    auto billboardView{registry->view<BillBoard, Transform, Material>()};
-    for (auto entity : billboardView) {
-        auto [billboard, transform, mat]{billboardView.get<BillBoard, Transform, Material>(entity)};
-        updateBillBoardTransformPrivate(billboard, transform, mat);
+    // Every local matrix in one call, several entities at a time
+    const size_t count{mBatch.size()};
+    mLocalTR.resize(count);
+    mLocalTRS.resize(count);
+    const GLfloat *const translation[3]{mBatchValues[0].data(), mBatchValues[1].data(), mBatchValues[2].data()};
+    const GLfloat *const orientation[4]{mBatchValues[3].data(), mBatchValues[4].data(), mBatchValues[5].data(), mBatchValues[6].data()};
+    const GLfloat *const scale[3]{mBatchValues[7].data(), mBatchValues[8].data(), mBatchValues[9].data()};
+    gsl::simd::composeTRS(count, translation, orientation, scale, mLocalTR.data(), mLocalTRS.data());
+    // Then chain them to their parents, which are done already since they come first
+    for (size_t i{0}; i < count; i++) {
+        updateColliders(mBatch[i]);
+        setWorldMatrix(mBatch[i], registry->get<Transform>(mBatch[i]), mLocalTR[i], mLocalTRS[i]);
     }
 }
-void MovementSystem::updateModelMatrix(GLuint eID)
+void MovementSystem::sortHierarchy()
 {
+    std::vector<GLuint> order;
+    std::vector<bool> visited;
+    std::vector<GLuint> stack;
     auto view{registry->view<Transform>()};
-    Transform &comp{view.get(eID)};
-    updateModelMatrix(comp);
-    updateColliders(eID);
-}
-void MovementSystem::updateModelMatrix(Transform &comp)
-{
-    if (comp.matrixOutdated) {
-        //calculate matrix from position, scale, rotation
-        updateTRS(comp);
-        auto view{registry->view<Transform>()};
-        if (comp.parentID != -1) {
-            Transform &parent{view.get(comp.parentID)};
-            gsl::Matrix4x4 parentMatrix{getTRMatrix(parent)};
-            comp.modelMatrix = parentMatrix * comp.translationMatrix * comp.rotationMatrix * comp.scaleMatrix;
-        }
-        else {
-            comp.position = comp.localPosition;
-            comp.rotation = comp.localRotation;
-            comp.modelMatrix = comp.translationMatrix * comp.rotationMatrix * comp.scaleMatrix;
-        }
-        comp.matrixOutdated = false;
-        for (auto child : comp.children) {
-            Transform &childComp{view.get(child)};
-            childComp.matrixOutdated = true;
+    order.reserve(view.size());
+    auto visit = [&](GLuint root) {
+        stack.push_back(root);
+        while (!stack.empty()) {
+            const GLuint entity{stack.back()};
+            stack.pop_back();
+            const GLuint index{Entity::index(entity)};
+            if (index >= visited.size())
+                visited.resize(index + 1);
+            else if (visited[index])
+                continue;
+            visited[index] = true;
+            order.push_back(index);
+            for (int child{view.get(entity).firstChild}; child != -1; child = view.get(child).nextSibling)
+                stack.push_back(static_cast<GLuint>(child));
         }
+    };
+    for (auto entity : view) {
+        if (view.get(entity).parentID == -1)
+            visit(entity);
     }
+    // Children whose parentID is set but aren't linked to the parent yet, e.g. while a scene is loading
+    for (auto entity : view) {
+        const GLuint index{Entity::index(entity)};
+        if (index >= visited.size() || !visited[index])
+            visit(entity);
+    }
+    registry->transforms().setOrder(std::move(order));
 }
 void MovementSystem::updateColliders(GLuint eID)
 {
+    // Both, a tower has a box and a range sphere
     if (registry->contains<AABB>(eID))
         registry->get<AABB>(eID).transform.matrixOutdated = true;
-    else if (registry->contains<Sphere>(eID))
+    if (registry->contains<Sphere>(eID))
         registry->get<Sphere>(eID).transform.matrixOutdated = true;
 }
 
-void MovementSystem::updateColliderTransformPrivate(Collision &col, const Transform &trans)
+void MovementSystem::updateColliderTransformPrivate(Collision &col, GLuint entity, const gsl::Matrix4x4 &offset, const vec3 &halfSize)
 {
-    col.transform.modelMatrix = getTRMatrix(trans) * col.transform.translationMatrix * col.transform.scaleMatrix;
+    const auto &transforms{std::as_const(*registry).transforms()};
+    col.transform.modelMatrix = transforms.worldTR(entity) * offset;
+    const vec3 center{col.transform.modelMatrix.getPosition()};
+    col.transform.worldMin = center - halfSize;
+    col.transform.worldMax = center + halfSize;
     col.transform.matrixOutdated = false;
+    col.transform.boundsOutdated = true;
 }
 void MovementSystem::updateBillBoardTransform(GLuint entity)
 {
     auto view{registry->view<BillBoard, Transform, Material>()};
     auto [billboard, transform, mat]{view.get<BillBoard, Transform, Material>(entity)};
-    updateBillBoardTransformPrivate(billboard, transform, mat);
+    updateBillBoardTransformPrivate(entity, billboard, transform, mat);
 }
-void MovementSystem::updateBillBoardTransformPrivate(const BillBoard &billboard, Transform &transform, const Material &mat)
+void MovementSystem::updateBillBoardTransformPrivate(GLuint entity, const BillBoard &billboard, Transform &transform, const Material &mat)
 {
+    // The world matrices aren't updated yet this frame, so a billboard with a parent faces the camera from where it was last frame
+    const vec3 position{transform.parentID == -1 ? transform.localPosition : registry->transforms().world(entity).getPosition()};
     // find direction between this and camera
     vec3 direction{};
     if (billboard.normalVersion) {
         vec3 camPosition{mat.shader->getCameraController()->cameraPosition()};
         //cancel height info so billboard is allways upright:
         if (billboard.constantYUp)
-            camPosition.setY(transform.modelMatrix.getPosition().y);
-        direction = camPosition - vec3(transform.modelMatrix.getPosition());
+            camPosition.setY(position.y);
+        direction = camPosition - position;
     }
     else {
         vec3 camDirection{mat.shader->getCameraController()->forward()};
         //cancel height info so billboard is allways upright:
         if (billboard.constantYUp)
-            camDirection.setY(transform.modelMatrix.getPosition().y);
+            camDirection.setY(position.y);
         direction = camDirection * -1;
     }
     direction.normalize();
     //set rotation to this direction
-    transform.rotationMatrix.setRotationToVector(direction);
-    transform.localRotation = std::get<2>(gsl::Matrix4x4::decomposed(transform.rotationMatrix));
-    transform.matrixOutdated = true;
+    const gsl::Quaternion orientation{gsl::Quaternion::lookRotation(direction)};
+    // Leaves a static scene with nothing to recompose
+    if (orientation == transform.localOrientation)
+        return;
+    transform.localOrientation = orientation;
+    registry->transforms().markDirty(entity);
 }
 
-gsl::Matrix4x4 MovementSystem::getTRMatrix(const Transform &comp)
+gsl::Matrix4x4 MovementSystem::getTSMatrix(const AABB &comp)
 {
-    if (comp.parentID != -1) {
-        Transform &parent{registry->view<Transform>().get(comp.parentID)};
-        gsl::Matrix4x4 parentMatrix{getTRMatrix(parent)};
-        return parentMatrix * comp.translationMatrix * comp.rotationMatrix;
-    }
-    else
-        return comp.translationMatrix * comp.rotationMatrix;
+    gsl::Matrix4x4 matrix(true);
+    matrix.translate(comp.origin);
+    matrix.scale(comp.size);
+    return matrix;
 }
-void MovementSystem::updateTRS(Transform &comp)
+gsl::Matrix4x4 MovementSystem::getTSMatrix(const Sphere &comp)
 {
-    //calculate matrix from position, scale, rotation
-    comp.translationMatrix.setToIdentity();
-    comp.translationMatrix.translate(comp.localPosition);
-
-    comp.rotationMatrix.setToIdentity();
-    comp.rotationMatrix.rotateX(comp.localRotation.x);
-    comp.rotationMatrix.rotateY(comp.localRotation.y);
-    comp.rotationMatrix.rotateZ(comp.localRotation.z);
-
-    comp.scaleMatrix.setToIdentity();
-    comp.scaleMatrix.scale(comp.localScale);
-}
-
-void MovementSystem::updateTS(AABB &comp)
-{
-    auto &trans{comp.transform};
-    //calculate matrix from position, scale, rotation
-    trans.translationMatrix.setToIdentity();
-    trans.translationMatrix.translate(comp.origin);
-
-    trans.scaleMatrix.setToIdentity();
-    trans.scaleMatrix.scale(comp.size);
-}
-void MovementSystem::updateTS(Sphere &comp)
-{
-    auto &trans{comp.transform};
-    //calculate matrix from position, scale, rotation
-    trans.translationMatrix.setToIdentity();
-    trans.translationMatrix.translate(comp.position);
-
-    trans.scaleMatrix.setToIdentity();
-    trans.scaleMatrix.scale(comp.radius);
+    gsl::Matrix4x4 matrix(true);
+    matrix.translate(comp.position);
+    matrix.scale(comp.radius);
+    return matrix;
 }
 
 gsl::Vector3D MovementSystem::getAbsolutePosition(GLuint eID)
 {
-    if (Registry::instance()->hasParent(eID)) {
-        auto view{registry->view<Transform>()};
-        auto &trans{view.get(eID)};
-        trans.position = view.get(eID).modelMatrix.getPosition();
-        return trans.position;
-    }
+    if (Registry::instance()->hasParent(eID))
+        return registry->get<Transform>(eID).position;
     return getLocalPosition(eID);
 }
 
@@ -187,11 +256,8 @@ gsl::Vector3D MovementSystem::getLocalPosition(GLuint eID)
 }
 gsl::Vector3D MovementSystem::getAbsoluteRotation(GLuint eID)
 {
-    if (Registry::instance()->hasParent(eID)) {
-        auto &trans{registry->view<Transform>().get(eID)};
-        trans.rotation = std::get<2>(gsl::Matrix4x4::decomposed(trans.modelMatrix));
-        return trans.rotation;
-    }
+    if (Registry::instance()->hasParent(eID))
+        return registry->get<Transform>(eID).orientation.toEuler();
     return getRelativeRotation(eID);
 }
 gsl::Vector3D MovementSystem::getRelativeRotation(GLuint eID)
@@ -209,7 +275,7 @@ void MovementSystem::setAbsolutePosition(GLuint eID, vec3 position, bool signal)
     else {
         trans.localPosition = position;
     }
-    trans.matrixOutdated = true;
+    registry->transforms().markDirty(eID);
     if (signal)
         emit positionChanged(eID, position, true);
 }
@@ -218,7 +284,7 @@ void MovementSystem::setLocalPosition(GLuint eID, vec3 position, bool signal)
 {
     auto view{registry->view<Transform>()};
     view.get(eID).localPosition = position;
-    view.get(eID).matrixOutdated = true;
+    registry->transforms().markDirty(eID);
     if (signal)
         emit positionChanged(eID, position, false);
 }
@@ -295,8 +361,10 @@ void MovementSystem::move(GLuint eID, const vec3 &moveDelta, bool signal)
 void MovementSystem::setRotation(GLuint eID, vec3 rotation, bool signal)
 {
     auto view{registry->view<Transform>()};
-    view.get(eID).matrixOutdated = true;
-    view.get(eID).localRotation = rotation;
+    auto &trans{view.get(eID)};
+    trans.localRotation = rotation;
+    trans.localOrientation = gsl::Quaternion::fromEuler(rotation);
+    registry->transforms().markDirty(eID);
     if (signal)
         emit rotationChanged(eID, rotation);
 }
@@ -339,7 +407,7 @@ void MovementSystem::setScale(GLuint eID, vec3 scale, bool signal)
 {
     auto &trans{registry->view<Transform>().get(eID)};
     trans.localScale = scale;
-    trans.matrixOutdated = true;
+    registry->transforms().markDirty(eID);
     if (signal)
         emit scaleChanged(eID, scale);
 }
@@ -4,6 +4,8 @@
 #include "core.h"
 #include "isystem.h"
 #include "matrix4x4.h"
+#include <array>
+#include <vector>
 struct Transform;
 struct AABB;
 struct Sphere;
@@ -23,9 +25,15 @@ public:
     MovementSystem();
 
     void update(DeltaTime dt = 0.016) override;
+    /**
+     * @brief Start of a fixed tick: saves the world matrices the renderer blends from, then moves everything with a Velocity.
+     * @param dt tick length
+     */
+    void updateFixed(DeltaTime dt);
     void init();
     /**
-     * @brief Get the absolute position of the entity from the entity's model matrix.
+     * @brief Get the absolute position of the entity, as of the last update.
+     * Read from the Transform, where it's cached whenever the model matrix is recalculated.
      * @param eID
      * @return vec3 containing the XYZ position of the entity
      */
@@ -37,7 +45,8 @@ public:
     */
     vec3 getLocalPosition(GLuint eID);
     /**
-     * @brief Get the absolute rotation of an object from the decomposed model matrix.
+     * @brief Get the absolute rotation of an object, as of the last update.
+     * Converted from the orientation cached in the Transform whenever the model matrix is recalculated.
      * @param eID
      * @return vec3 containing euler rotation values
      */
@@ -142,16 +151,44 @@ signals:
 
 private:
     Registry *registry;
+    /// Entities updated by updateHierarchy() this frame, parents first. Kept between frames to reuse the memory.
+    std::vector<GLuint> mBatch;
+    /// Local position, orientation and scale of the batch, one array per component (x, y, z, then x, y, z, w, then x, y, z).
+    std::array<std::vector<GLfloat>, 10> mBatchValues;
+    /// Local matrices of the batch, with and without scale.
+    std::vector<gsl::Matrix4x4> mLocalTR, mLocalTRS;
+    /// Entities moved by integrate() this tick, their Transforms, and their positions and velocities packed x, y, z after each other.
+    std::vector<GLuint> mMoving;
+    std::vector<Transform *> mMovingTransforms;
+    std::vector<GLfloat> mPositions, mVelocities;
+    /**
+     * @brief Add velocity * dt to the localPosition of every entity with a Velocity, in one vectorized pass.
+     * @param dt
+     */
+    void integrate(DeltaTime dt);
+    /**
+     * @brief Set the world matrices of an entity from its local matrices and its parent's cached world TR matrix.
+     * @param eID
+     * @param comp Transform component of the entity, gets its absolute position and rotation cached.
+     * @param localTR
+     * @param localTRS
+     */
+    void setWorldMatrix(GLuint eID, Transform &comp, const gsl::Matrix4x4 &localTR, const gsl::Matrix4x4 &localTRS);
     /**
-     * @brief Update the entity's model matrix if it's outdated, otherwise does nothing.
-     * @param eID entityID
+     * @brief Flag the children of a Transform as outdated.
+     * @param comp
+     */
+    void flagChildren(const Transform &comp);
+    /**
+     * @brief Update every outdated Transform and their children in one pass over the hierarchy order.
+     * Clean subtrees cost a single bit test per entity.
+     * The local matrices of every outdated Transform are composed in one batch by gsl::simd::composeTRS().
      */
-    void updateModelMatrix(GLuint eID);
+    void updateHierarchy();
     /**
-     * @copybrief MovementSystem::updateModelMatrix(GLuint)
-     * @param comp Transform component of the entity.
+     * @brief Rebuild the hierarchy order in Registry::transforms(), parents before children, after a link changed.
      */
-    void updateModelMatrix(Transform &comp);
+    void sortHierarchy();
     /**
      * @brief Sets an entity's colliders to outdated.
      * @param eID entityID
@@ -159,28 +196,17 @@ private:
     void updateColliders(GLuint eID);
 
     /**
-     * @brief Get the Translation and Rotation matrices of a component, multiplied by its parent TR matrices if it has a parent.
-     * We don't want to inherit the scale of the parent, since that can lead to wrong scaling for the child object.
+     * @brief Build the Translation * Scale matrix of an AABB collider, relative to its owner.
      * @param comp
      * @return
      */
-    gsl::Matrix4x4 getTRMatrix(const Transform &comp);
-
+    static gsl::Matrix4x4 getTSMatrix(const AABB &comp);
     /**
-     * @brief Update a Transform component's Scale, Rotation and Translation matrices, in that order.
-     * @param comp
-     */
-    void updateTRS(Transform &comp);
-    /**
-     * @brief Update the transform component belonging to the AABB component given.
-     * @param comp
-     */
-    void updateTS(AABB &comp);
-    /**
-     * @brief Update the transform component belonging to the Sphere component given.
+     * @brief Build the Translation * Scale matrix of a Sphere collider, relative to its owner.
      * @param comp
+     * @return
      */
-    void updateTS(Sphere &comp);
+    static gsl::Matrix4x4 getTSMatrix(const Sphere &comp);
 
     /**
      * @brief Specialized function for billboards, public.
@@ -189,17 +215,21 @@ private:
     void updateBillBoardTransform(GLuint entity);
     /**
      * @brief Actually updates the colliders of each entity.
+     * Colliders don't inherit the scale of their owner, so they're placed relative to its cached world TR matrix.
      * @param col
-     * @param trans
+     * @param entity owner of the collider
+     * @param offset the collider's matrix relative to its owner, from getTSMatrix()
+     * @param halfSize half the size of the collider's world space box, which is centred on the collider
      */
-    void updateColliderTransformPrivate(Collision &col, const Transform &trans);
+    void updateColliderTransformPrivate(Collision &col, GLuint entity, const gsl::Matrix4x4 &offset, const vec3 &halfSize);
     /**
      * @brief Private version of the updateBillBoardTransform function, does the actual updating.
+     * @param entity
      * @param billboard
      * @param transform
      * @param mat
      */
-    void updateBillBoardTransformPrivate(const BillBoard &billboard, Transform &transform, const Material &mat);
+    void updateBillBoardTransformPrivate(GLuint entity, const BillBoard &billboard, Transform &transform, const Material &mat);
 };
 
 #endif // MOVEMENTSYSTEM_H
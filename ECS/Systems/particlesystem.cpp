@@ -8,6 +8,9 @@
 ParticleSystem::ParticleSystem(cjk::Ref<ParticleShader> shader)
     : registry{Registry::instance()}, mShader{shader}
 {
+    addReads<Transform>();
+    addWrites<ParticleEmitter>();
+    mContextThread = true;
     rng = std::mt19937(std::random_device()());
 }
 
@@ -31,17 +34,26 @@ void ParticleSystem::update(DeltaTime)
 {
 }
 
-void ParticleSystem::updatePlayOnly(DeltaTime deltaTime)
+void ParticleSystem::updatePlayOnly(DeltaTime)
 {
-    auto view{registry->view<ParticleEmitter, Transform>()};
+    auto view{registry->view<ParticleEmitter>()};
     initializeOpenGLFunctions();
+    for (auto entity : view) {
+        auto &emitter{view.get(entity)};
+        if (emitter.isActive)
+            renderParticles(emitter);
+    }
+}
+
+void ParticleSystem::updateFixed(DeltaTime deltaTime)
+{
+    auto view{registry->view<ParticleEmitter, Transform>()};
     for (auto entity : view) {
         auto [emitter, transform]{view.get<ParticleEmitter, Transform>(entity)};
         if (emitter.isActive) {
             generateParticles(deltaTime, emitter, transform);
             simulateParticles(deltaTime, emitter);
-            renderParticles(emitter);
-            if (emitter.shouldDecay) { // if the emitter should only create a short burst of particles, we reduce the lifespan of each of its particles every frame.
+            if (emitter.shouldDecay) { // if the emitter should only create a short burst of particles, we reduce the lifespan of each of its particles every tick.
                 emitter.lifeSpan -= deltaTime;
                 if (emitter.lifeSpan <= 0) {
                     emitter.isActive = false;
@@ -30,7 +30,15 @@ public:
     void initEmitter(GLuint entityID);
 
     void update(DeltaTime = 0.016) override;
+    /**
+     * @brief Draws the active emitters' particles as of the last tick.
+     */
     void updatePlayOnly(DeltaTime deltaTime = 0.016);
+    /**
+     * @brief Spawns and moves the particles of every active emitter, once per fixed tick.
+     * @param deltaTime tick length
+     */
+    void updateFixed(DeltaTime deltaTime);
 public slots:
     void setInitDirX(double xIn);
     void setInitDirY(double yIn);
@@ -3,6 +3,7 @@
 #include "colorshader.h"
 #include "components.h"
 #include "group.h"
+#include "gsl_math.h"
 #include "inputsystem.h"
 #include "phongshader.h"
 #include "registry.h"
@@ -10,9 +11,13 @@
 #include "skyboxshader.h"
 #include "textureshader.h"
 #include "view.h"
+#include <utility>
 
 RenderSystem::RenderSystem() : registry{Registry::instance()}
 {
+    addReads<Transform, Material, AABB>();
+    addWrites<Mesh>();
+    mContextThread = true;
     [[maybe_unused]] auto group{registry->group<Transform, Material, Mesh>()}; // Creating a group early reduces initial cost of first-time creation.
 }
 
@@ -25,7 +30,12 @@ void RenderSystem::drawEntities()
         auto [transform, material, mesh]{group.get<Transform, Material, Mesh>(entity)}; // Structured bindings (c++17), creates and assigns from tuple
         if (mesh.rendered) {
             glUseProgram(material.shader->getProgram());
-            material.shader->transmitUniformData(transform.modelMatrix, &material);
+            if (mAlpha < 1.f) {
+                gsl::Matrix4x4 model{interpolatedWorld(entity, transform)};
+                material.shader->transmitUniformData(model, &material);
+            }
+            else
+                material.shader->transmitUniformData(registry->transforms().world(entity), &material);
             glBindVertexArray(mesh.VAO);
             if (mesh.indiceCount > 0)
                 glDrawElements(mesh.drawType, mesh.indiceCount, GL_UNSIGNED_INT, nullptr);
@@ -35,6 +45,18 @@ void RenderSystem::drawEntities()
     }
     drawSkybox();
 }
+gsl::Matrix4x4 RenderSystem::interpolatedWorld(GLuint entity, const Transform &transform) const
+{
+    const auto &transforms{std::as_const(*registry).transforms()};
+    const gsl::Matrix4x4 &current{transforms.worldTR(entity)};
+    // Nothing to blend for entities that didn't move during the last tick, or didn't exist before it
+    if (!transforms.hasPrevious(entity) || transforms.previousTR(entity) == current)
+        return transforms.world(entity);
+    const gsl::Matrix4x4 &previous{transforms.previousTR(entity)};
+    const gsl::Vector3D position{gsl::lerp3D(mAlpha, previous.getPosition(), current.getPosition())};
+    const gsl::Quaternion orientation{gsl::Quaternion::slerp(gsl::Quaternion::fromMatrix(previous), gsl::Quaternion::fromMatrix(current), mAlpha)};
+    return gsl::Matrix4x4::composeTRS(position, orientation, transform.localScale);
+}
 void RenderSystem::update(DeltaTime)
 {
     drawEntities();
@@ -60,14 +82,16 @@ void RenderSystem::drawSkybox()
 void RenderSystem::drawColliders()
 {
     auto view{registry->view<AABB>()};
-    ColorShader *shader{ResourceManager::instance()->getShader<ColorShader>().get()};
+    auto factory{ResourceManager::instance()};
+    ColorShader *shader{factory->getShader<ColorShader>().get()};
+    // Every box is the same unit cube, placed and scaled by its model matrix
+    const Mesh box{factory->getColliderBoxMesh()};
+    glUseProgram(shader->getProgram());
+    glBindVertexArray(box.VAO);
     for (auto entity : view) {
         auto &aabb{view.get(entity)};
-        glUseProgram(shader->getProgram());
-        // For AABB you could possibly alter the modelMatrix by a desired position or scale(half-size) before sending it to the shader.
         shader->transmitUniformData(aabb.transform.modelMatrix, nullptr); // no need to send a material since the box collider is just lines
-        glBindVertexArray(aabb.colliderMesh.VAO);
-        glDrawArrays(aabb.colliderMesh.drawType, 0, aabb.colliderMesh.verticeCount);
+        glDrawArrays(box.drawType, 0, box.verticeCount);
     }
 }
 
@@ -8,6 +8,7 @@
 #include <QOpenGLFunctions_4_1_Core>
 
 class Registry;
+struct Transform;
 /**
  * @brief The RenderSystem class draws all objects containing at least Transform, Material and Mesh components.
  */
@@ -20,6 +21,12 @@ public:
     void updateEditorOnly();
 
     void setSkyBoxID(const GLuint &skyBoxID);
+    /**
+     * @brief Set how far the frame is between the last two simulation ticks, see Scheduler::alpha().
+     * Entities are drawn blended between their world matrices at the two ticks, or as they are now at 1.
+     * @param alpha
+     */
+    void setInterpolation(float alpha) { mAlpha = alpha; }
 
 public slots:
     /**
@@ -44,6 +51,7 @@ signals:
 
 private:
     Registry *registry;
+    float mAlpha{1};
     /**
     * @brief Render entities that want to be rendered (Mesh.isRendered).
     */
@@ -58,6 +66,14 @@ private:
      * @brief Draw the skybox with its own shader and OpenGL settings.
      */
     void drawSkybox();
+    /**
+     * @brief The entity's world matrix blended between the last two ticks by mAlpha.
+     * Position is interpolated linearly and rotation spherically, the scale is the current one.
+     * @param entity
+     * @param transform
+     * @return
+     */
+    gsl::Matrix4x4 interpolatedWorld(GLuint entity, const Transform &transform) const;
     void Cull(const Camera::Frustum &f);
 };
 
@@ -5,6 +5,9 @@
 
 SoundSystem::SoundSystem() : registry{Registry::instance()}
 {
+    addReads<Transform>();
+    addWrites<Sound>();
+    mContextThread = true; // OpenAL listener follows the current camera
 }
 
 void SoundSystem::cleanUp()
@@ -64,7 +67,7 @@ void SoundSystem::updatePlayOnly()
     auto view{registry->view<Transform, Sound>()};
     for (auto entity : view) {
         const auto &transform{view.get<Transform>(entity)};
-        if (transform.matrixOutdated) // keep in mind this check only works if soundsystem's "updatePlayOnly" function runs before movesystem
+        if (registry->transforms().isDirty(entity)) // keep in mind this check only works if soundsystem's "updatePlayOnly" function runs before movesystem
             setPosition(entity, transform.position);
     }
 }
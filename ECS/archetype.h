@@ -0,0 +1,555 @@
+#ifndef ARCHETYPE_H
+#define ARCHETYPE_H
+
+#include "core.h"
+#include "entity.h"
+#include "family.h"
+#include "gltypes.h"
+#include "threadpool.h"
+#include <array>
+#include <cassert>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The IColumn class is the type-erased interface for one component column of an Archetype.
+ */
+class IColumn {
+public:
+    virtual ~IColumn() = default;
+    /**
+     * Deep copy of the column, components included.
+     */
+    virtual IColumn *clone() const = 0;
+    /**
+     * New, empty column of the same component type.
+     */
+    virtual IColumn *emptyCopy() const = 0;
+    /**
+     * Moves the component at row in other to the back of this column.
+     */
+    virtual void moveFrom(IColumn &other, size_t row) = 0;
+    /**
+     * Copies the component at row in other to the back of this column.
+     */
+    virtual void copyFrom(const IColumn &other, size_t row) = 0;
+    /**
+     * Removes the component at row by moving the last component into its place.
+     */
+    virtual void remove(size_t row) = 0;
+    virtual size_t memoryUsage() const = 0;
+};
+
+template <typename Type>
+/**
+ * The Column class holds the components of one type for every entity in an Archetype, tightly packed.
+ */
+class Column : public IColumn {
+public:
+    IColumn *clone() const override { return new Column<Type>{*this}; }
+    IColumn *emptyCopy() const override { return new Column<Type>{}; }
+    void moveFrom(IColumn &other, size_t row) override
+    {
+        mData.push_back(std::move(static_cast<Column<Type> &>(other).mData[row]));
+    }
+    void copyFrom(const IColumn &other, size_t row) override
+    {
+        mData.push_back(static_cast<const Column<Type> &>(other).mData[row]);
+    }
+    void remove(size_t row) override
+    {
+        if (row + 1 != mData.size())
+            mData[row] = std::move(mData.back());
+        mData.pop_back();
+    }
+    size_t memoryUsage() const override { return mData.capacity() * sizeof(Type); }
+
+    std::vector<Type> mData;
+};
+
+/**
+ * The Archetype struct is the table holding every entity that owns exactly the component types in its signature.
+ * Each component type gets its own column, and row n of every column belongs to entities[n].
+ */
+struct Archetype {
+    Archetype(const Signature &sig) : signature(sig)
+    {
+        next.fill(-1);
+        prev.fill(-1);
+    }
+    Signature signature;
+    /// Entity owning each row.
+    std::vector<GLuint> entities;
+    /// Component columns, indexed by ComponentFamily index. nullptr for types not in the signature.
+    std::vector<cjk::Scope<IColumn>> columns;
+    /// The ComponentFamily indices in the signature, for walking the columns.
+    std::vector<size_t> types;
+    /// Archetype reached by adding (next) or removing (prev) a type, -1 until first needed.
+    std::array<int, MaxComponents> next, prev;
+};
+
+/**
+ * The ArchetypeStorage class is the table-per-signature alternative to keeping one Pool per component type.
+ * Entities with the same set of components share an Archetype, so iterating several component types
+ * at once walks dense columns instead of probing other pools for membership.
+ * Adding or removing a component moves the entity's row to the Archetype matching its new signature.
+ * Enabled with DEFINES += CJK_ARCHETYPE_STORAGE, in which case Registry routes its component API here.
+ */
+class ArchetypeStorage {
+    struct Record {
+        int table{-1};
+        size_t row{0};
+    };
+
+public:
+    ArchetypeStorage() = default;
+    ArchetypeStorage(const ArchetypeStorage &other) { *this = other; }
+    ArchetypeStorage &operator=(const ArchetypeStorage &other)
+    {
+        if (this == &other)
+            return *this;
+        mArchetypes.clear();
+        for (const auto &archetype : other.mArchetypes) {
+            auto copy{std::make_unique<Archetype>(archetype->signature)};
+            copy->entities = archetype->entities;
+            copy->types = archetype->types;
+            copy->next = archetype->next;
+            copy->prev = archetype->prev;
+            copy->columns.resize(archetype->columns.size());
+            for (size_t type : archetype->types)
+                copy->columns[type].reset(archetype->columns[type]->clone());
+            mArchetypes.push_back(std::move(copy));
+        }
+        mPrototypes.clear();
+        for (const auto &prototype : other.mPrototypes)
+            mPrototypes.emplace_back(prototype ? prototype->emptyCopy() : nullptr);
+        mRecords = other.mRecords;
+        mLookup = other.mLookup;
+        mQueries = other.mQueries;
+        return *this;
+    }
+
+    template <typename Type>
+    static size_t type() { return ComponentFamily::type<Type>; }
+    template <typename... Type>
+    static Signature signature()
+    {
+        Signature sig;
+        (sig.set(type<Type>()), ...);
+        return sig;
+    }
+
+    /**
+     * Adds a component to an entity, moving the entity to the Archetype that also holds Type.
+     * @return the new component.
+     */
+    template <typename Type, typename... Args>
+    Type &add(const GLuint entityID, Args... args)
+    {
+        assert(!contains<Type>(entityID)); // Make sure the entity doesn't own one already.
+        assurePrototype<Type>();
+        const int source{record(entityID).table};
+        const size_t target{source == -1 ? find(signature<Type>()) : transition(source, type<Type>(), true)};
+        place(entityID, target);
+        auto &data{column<Type>(target)->mData};
+        data.push_back(Type{args...});
+        return data.back();
+    }
+    /**
+     * Removes a component from an entity, moving the entity to the Archetype without Type.
+     */
+    template <typename Type>
+    void remove(const GLuint entityID)
+    {
+        if (!contains<Type>(entityID))
+            return;
+        place(entityID, transition(record(entityID).table, type<Type>(), false));
+    }
+    /**
+     * Removes every component except the ones in keep.
+     */
+    void strip(const GLuint entityID, const Signature &keep)
+    {
+        const int source{record(entityID).table};
+        if (source == -1)
+            return;
+        const Signature sig{mArchetypes[source]->signature & keep};
+        if (sig != mArchetypes[source]->signature)
+            place(entityID, find(sig));
+    }
+    /**
+     * Gives the entity to a copy of every component owned by cloneFrom that it doesn't already have.
+     */
+    void clone(const GLuint cloneFrom, const GLuint cloneTo)
+    {
+        const int source{record(cloneFrom).table};
+        if (source == -1)
+            return;
+        const int before{record(cloneTo).table};
+        const Signature owned{before == -1 ? Signature{} : mArchetypes[before]->signature};
+        const size_t target{find(mArchetypes[source]->signature | owned)};
+        place(cloneTo, target);
+        // cloneFrom may have been swapped into a new row if both entities shared an archetype
+        const Record from{record(cloneFrom)};
+        for (size_t type : mArchetypes[target]->types) {
+            if (!owned.test(type))
+                mArchetypes[target]->columns[type]->copyFrom(*mArchetypes[from.table]->columns[type], from.row);
+        }
+    }
+    template <typename Type>
+    Type &get(const GLuint entityID)
+    {
+        assert(contains<Type>(entityID));
+        const Record &rec{mRecords[Entity::index(entityID)]};
+        return column<Type>(rec.table)->mData[rec.row];
+    }
+    template <typename Type>
+    bool contains(const GLuint entityID) const
+    {
+        return contains(entityID, signature<Type>());
+    }
+    /**
+     * Check if the entity owns every component type in sig.
+     */
+    bool contains(const GLuint entityID, const Signature &sig) const
+    {
+        const GLuint index{Entity::index(entityID)};
+        if (index >= mRecords.size() || mRecords[index].table == -1)
+            return false;
+        const Archetype &archetype{*mArchetypes[mRecords[index].table]};
+        if (archetype.entities[mRecords[index].row] != entityID) // Stale handle to an entity that used the same index
+            return false;
+        return (archetype.signature & sig) == sig;
+    }
+    /**
+     * List of every Archetype index whose signature contains sig.
+     * The list is cached, and kept up to date as new Archetypes are created.
+     */
+    const std::vector<size_t> &match(const Signature &sig)
+    {
+        auto it{mQueries.find(sig)};
+        if (it == mQueries.end()) {
+            std::vector<size_t> tables;
+            for (size_t i{0}; i < mArchetypes.size(); i++) {
+                if ((mArchetypes[i]->signature & sig) == sig)
+                    tables.push_back(i);
+            }
+            it = mQueries.emplace(sig, std::move(tables)).first;
+        }
+        return it->second;
+    }
+    Archetype &table(size_t index) { return *mArchetypes[index]; }
+    const Archetype &table(size_t index) const { return *mArchetypes[index]; }
+    template <typename Type>
+    Column<Type> *column(size_t table)
+    {
+        return static_cast<Column<Type> *>(mArchetypes[table]->columns[type<Type>()].get());
+    }
+    /**
+     * Every entity owning all of the types in sig.
+     */
+    std::vector<GLuint> entities(const Signature &sig)
+    {
+        std::vector<GLuint> list;
+        for (size_t table : match(sig))
+            list.insert(list.end(), mArchetypes[table]->entities.begin(), mArchetypes[table]->entities.end());
+        return list;
+    }
+    /**
+     * Number of entities owning all of the types in sig.
+     */
+    size_t count(const Signature &sig)
+    {
+        size_t num{0};
+        for (size_t table : match(sig))
+            num += mArchetypes[table]->entities.size();
+        return num;
+    }
+    size_t memoryUsage() const
+    {
+        size_t bytes{mRecords.capacity() * sizeof(Record)};
+        for (const auto &archetype : mArchetypes) {
+            bytes += sizeof(Archetype) + archetype->entities.capacity() * sizeof(GLuint);
+            for (size_t type : archetype->types)
+                bytes += archetype->columns[type]->memoryUsage();
+        }
+        return bytes;
+    }
+
+private:
+    std::vector<cjk::Scope<Archetype>> mArchetypes;
+    /// One empty column per component type seen so far, used to build the columns of new Archetypes.
+    std::vector<cjk::Scope<IColumn>> mPrototypes;
+    /// Location of each entity, indexed by the index bits of its handle.
+    std::vector<Record> mRecords;
+    /// Archetype index for each signature.
+    std::unordered_map<Signature, size_t> mLookup;
+    /// Cached results of match().
+    std::unordered_map<Signature, std::vector<size_t>> mQueries;
+
+    Record &record(const GLuint entityID)
+    {
+        const GLuint index{Entity::index(entityID)};
+        if (index >= mRecords.size())
+            mRecords.resize(index + 1);
+        return mRecords[index];
+    }
+    template <typename Type>
+    void assurePrototype()
+    {
+        const size_t index{type<Type>()};
+        assert(index < MaxComponents);
+        if (index >= mPrototypes.size())
+            mPrototypes.resize(index + 1);
+        if (!mPrototypes[index])
+            mPrototypes[index] = std::make_unique<Column<Type>>();
+    }
+    /**
+     * Archetype index for the given signature, creating it if it doesn't exist yet.
+     */
+    size_t find(const Signature &sig)
+    {
+        if (auto it = mLookup.find(sig); it != mLookup.end())
+            return it->second;
+        auto archetype{std::make_unique<Archetype>(sig)};
+        archetype->columns.resize(mPrototypes.size());
+        for (size_t type{0}; type < mPrototypes.size(); type++) {
+            if (sig.test(type)) {
+                archetype->columns[type].reset(mPrototypes[type]->emptyCopy());
+                archetype->types.push_back(type);
+            }
+        }
+        const size_t index{mArchetypes.size()};
+        mArchetypes.push_back(std::move(archetype));
+        mLookup.emplace(sig, index);
+        for (auto &query : mQueries) {
+            if ((sig & query.first) == query.first)
+                query.second.push_back(index);
+        }
+        return index;
+    }
+    /**
+     * Archetype reached from table by adding or removing a type. Cached as an edge on the Archetype.
+     */
+    size_t transition(size_t table, size_t type, bool add)
+    {
+        auto &edges{add ? mArchetypes[table]->next : mArchetypes[table]->prev};
+        if (edges[type] == -1) {
+            Signature sig{mArchetypes[table]->signature};
+            sig.set(type, add);
+            edges[type] = static_cast<int>(find(sig));
+        }
+        return static_cast<size_t>(edges[type]);
+    }
+    /**
+     * Moves an entity's row to target, carrying over every component both Archetypes have in common.
+     * Components target has that the source lacks must be pushed by the caller.
+     * An empty target signature takes the entity out of the storage.
+     */
+    void place(const GLuint entityID, size_t target)
+    {
+        const Record source{record(entityID)};
+        if (source.table == static_cast<int>(target))
+            return;
+        if (mArchetypes[target]->signature.any()) {
+            Archetype &to{*mArchetypes[target]};
+            if (source.table != -1) {
+                Archetype &from{*mArchetypes[source.table]};
+                for (size_t type : to.types) {
+                    if (from.signature.test(type))
+                        to.columns[type]->moveFrom(*from.columns[type], source.row);
+                }
+            }
+            to.entities.push_back(entityID);
+            mRecords[Entity::index(entityID)] = {static_cast<int>(target), to.entities.size() - 1};
+        }
+        else
+            mRecords[Entity::index(entityID)] = {};
+        if (source.table != -1)
+            erase(source.table, source.row);
+    }
+    /**
+     * Swap-and-pop a row out of an Archetype, keeping the record of the entity moved into its place up to date.
+     */
+    void erase(size_t table, size_t row)
+    {
+        Archetype &archetype{*mArchetypes[table]};
+        for (size_t type : archetype.types)
+            archetype.columns[type]->remove(row);
+        if (row + 1 != archetype.entities.size()) {
+            archetype.entities[row] = archetype.entities.back();
+            mRecords[Entity::index(archetype.entities[row])].row = row;
+        }
+        archetype.entities.pop_back();
+    }
+};
+
+/**
+ * Archetype-backed View.
+ * Iterates every Archetype whose signature contains all the given component types, so each visited entity
+ * is guaranteed to own them without probing any other storage.
+ * Same interface as the Pool-backed View, and returned by Registry::view() and Registry::group() when
+ * the engine is built with CJK_ARCHETYPE_STORAGE.
+ */
+template <typename... Component>
+class ArchetypeView {
+    /**
+     * The iterator class walks the matching Archetypes in order, and the rows of each Archetype back to front
+     * the same way the Pool iterator does, so removing the current entity doesn't skip any other entity.
+     */
+    class iterator {
+        friend class ArchetypeView<Component...>;
+
+        iterator(const ArchetypeStorage *store, const std::vector<size_t> *list, size_t pos)
+            : storage{store}, tables{list}, table{pos}
+        {
+            seek();
+        }
+        void seek()
+        {
+            while (table < tables->size() && !(row = storage->table((*tables)[table]).entities.size()))
+                ++table;
+        }
+
+    public:
+        using difference_type = std::int32_t;
+        using pointer = const GLuint *;
+        using reference = const GLuint &;
+        using iterator_category = std::forward_iterator_tag;
+
+        iterator() = default;
+
+        iterator &operator++()
+        {
+            if (--row == 0) {
+                ++table;
+                seek();
+            }
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator orig = *this;
+            return ++(*this), orig;
+        }
+
+        bool operator==(const iterator &other) const
+        {
+            return other.table == table && other.row == row;
+        }
+
+        bool operator!=(const iterator &other) const
+        {
+            return !(*this == other);
+        }
+
+        pointer operator->() const
+        {
+            return &storage->table((*tables)[table]).entities[row - 1];
+        }
+
+        reference operator*() const
+        {
+            return *operator->();
+        }
+
+    private:
+        const ArchetypeStorage *storage;
+        const std::vector<size_t> *tables;
+        size_t table{0};
+        size_t row{0};
+    };
+
+public:
+    /**
+     * Number of entities observed by this View.
+     * @return
+     */
+    size_t size() const
+    {
+        size_t num{0};
+        for (size_t table : *tables)
+            num += storage->table(table).entities.size();
+        return num;
+    }
+    bool empty() const { return size() == 0; }
+    iterator begin() const { return iterator{storage, tables, 0}; }
+    iterator end() const { return iterator{storage, tables, tables->size()}; }
+    /**
+     * Helper function to check if an entity is contained within this View.
+     * @param entt Entity ID.
+     * @return
+     */
+    bool contains(const int &entt) const
+    {
+        if (entt < 0)
+            return false;
+        return storage->contains(entt, ArchetypeStorage::signature<Component...>());
+    }
+    /**
+     * Retrieves the desired components from an entity, same as View::get().
+     * Leaving out the template arguments on a single component View returns that component.
+     * @return Either a reference to one component or a tuple containing a reference to each component type.
+     */
+    template <typename... Comp>
+    decltype(auto) get(const int &entt) const
+    {
+        assert(contains(entt));
+        if constexpr (sizeof...(Comp) == 0) {
+            return get<Component...>(entt);
+        }
+        else if constexpr (sizeof...(Comp) == 1) {
+            return (storage->template get<Comp>(entt), ...);
+        }
+        else
+            return std::tuple<decltype(get<Comp>(entt))...>{get<Comp>(entt)...};
+    }
+    /**
+     * Calls func(entity, Component &...) for every entity in the View, walking each Archetype's columns directly.
+     * @param func
+     */
+    template <typename Func>
+    void each(Func func) const
+    {
+        for (size_t table : *tables) {
+            auto &entities{storage->table(table).entities};
+            auto columns{std::make_tuple(storage->template column<Component>(table)->mData.data()...)};
+            for (size_t row{entities.size()}; row > 0; row--) {
+                func(entities[row - 1], std::get<Component *>(columns)[row - 1]...);
+            }
+        }
+    }
+    /**
+     * Parallel version of each(), with the same rules as View::par_each(). Each matching Archetype is split into chunks.
+     * @param func Callable taking (GLuint entity, Component &...).
+     * @param chunkSize Entities per chunk, 0 to let the pool decide.
+     */
+    template <typename Func>
+    void par_each(Func func, size_t chunkSize = 0) const
+    {
+        for (size_t table : *tables) {
+            const GLuint *entity{storage->table(table).entities.data()};
+            auto columns{std::make_tuple(storage->template column<Component>(table)->mData.data()...)};
+            ThreadPool::instance()->parallelFor(storage->table(table).entities.size(), chunkSize, [&](size_t first, size_t last) {
+                for (size_t pos{first}; pos < last; pos++)
+                    func(entity[pos], std::get<Component *>(columns)[pos]...);
+            });
+        }
+    }
+
+private:
+    ArchetypeView(ArchetypeStorage *store)
+        : storage{store}, tables{&store->match(ArchetypeStorage::signature<Component...>())}
+    {
+    }
+    /// Storage observed by this View.
+    ArchetypeStorage *storage;
+    /// Indices of the Archetypes matching this View, owned by the storage.
+    const std::vector<size_t> *tables;
+
+    friend class Registry;
+};
+
+#endif // ARCHETYPE_H
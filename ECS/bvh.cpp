@@ -0,0 +1,257 @@
+#include "bvh.h"
+#include <array>
+#include <limits>
+#include <numeric>
+
+namespace {
+/// Number of candidate split planes tried per axis, minus one
+constexpr int BinCount{12};
+/// Leaves may hold more items than this only if their items can't be told apart. One AVX register's worth, see order().
+constexpr GLuint MaxLeafSize{8};
+/// Cost of visiting a node, relative to testing an item. Items in a leaf are tested several at a time, so they're cheap.
+constexpr float TraversalCost{2.f};
+constexpr float Infinity{std::numeric_limits<float>::infinity()};
+
+using vec3 = gsl::Vector3D;
+vec3 minimum(const vec3 &lhs, const vec3 &rhs)
+{
+    return vec3{std::min(lhs.x, rhs.x), std::min(lhs.y, rhs.y), std::min(lhs.z, rhs.z)};
+}
+vec3 maximum(const vec3 &lhs, const vec3 &rhs)
+{
+    return vec3{std::max(lhs.x, rhs.x), std::max(lhs.y, rhs.y), std::max(lhs.z, rhs.z)};
+}
+/// Half the surface area of a box, enough to compare boxes
+float area(const vec3 &min, const vec3 &max)
+{
+    const vec3 size{max - min};
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+struct Bin {
+    vec3 min{Infinity, Infinity, Infinity};
+    vec3 max{-Infinity, -Infinity, -Infinity};
+    GLuint count{0};
+
+    void grow(const vec3 &minIn, const vec3 &maxIn)
+    {
+        min = minimum(min, minIn);
+        max = maximum(max, maxIn);
+    }
+    void grow(const Bin &bin)
+    {
+        if (bin.count) {
+            grow(bin.min, bin.max);
+            count += bin.count;
+        }
+    }
+    float cost() const { return count ? area(min, max) * count : 0.f; }
+};
+} // namespace
+
+void BVH::build(std::vector<Bounds> bounds)
+{
+    mBounds = std::move(bounds);
+    mNodes.clear();
+    mOrder.resize(mBounds.size());
+    std::iota(mOrder.begin(), mOrder.end(), 0);
+    mBuiltCost = 0.f;
+    if (mBounds.empty())
+        return;
+    mNodes.reserve(mBounds.size() * 2);
+    Node root;
+    root.count = static_cast<GLuint>(mBounds.size());
+    fitUnsorted(root);
+    mNodes.push_back(root);
+    std::vector<GLuint> pending{0};
+    while (!pending.empty()) {
+        const GLuint node{pending.back()};
+        pending.pop_back();
+        if (split(node)) {
+            pending.push_back(static_cast<GLuint>(mNodes.size()) - 2);
+            pending.push_back(static_cast<GLuint>(mNodes.size()) - 1);
+        }
+    }
+    // split() only sorted mOrder, the boxes follow it so items and leaves line up
+    std::vector<Bounds> sorted(mBounds.size());
+    for (size_t i{0}; i < mOrder.size(); i++)
+        sorted[i] = mBounds[mOrder[i]];
+    mBounds = std::move(sorted);
+    mBuiltCost = cost();
+}
+
+GLuint BVH::insert(const vec3 &min, const vec3 &max)
+{
+    const GLuint item{static_cast<GLuint>(mBounds.size())};
+    mBounds.push_back(Bounds{min, max});
+    mOrder.push_back(item);
+    Node added;
+    added.min = min;
+    added.max = max;
+    added.first = item;
+    added.count = 1;
+    if (mNodes.empty()) {
+        mNodes.push_back(added);
+        mBuiltCost = cost();
+        return item;
+    }
+    // Walk down to the leaf whose box grows the least, growing every box on the way since they'll all hold the item
+    GLuint index{0};
+    while (mNodes[index].count == 0) {
+        Node &node{mNodes[index]};
+        node.min = minimum(node.min, min);
+        node.max = maximum(node.max, max);
+        const Node &left{mNodes[node.first]};
+        const Node &right{mNodes[node.first + 1]};
+        const float leftGrowth{area(minimum(left.min, min), maximum(left.max, max)) - area(left.min, left.max)};
+        const float rightGrowth{area(minimum(right.min, min), maximum(right.max, max)) - area(right.min, right.max)};
+        index = leftGrowth <= rightGrowth ? node.first : node.first + 1;
+    }
+    Node &leaf{mNodes[index]};
+    // A leaf's items have to be next to each other, so the item can only join the leaf holding the last items
+    if (leaf.first + leaf.count == item && leaf.count < MaxLeafSize) {
+        leaf.count++;
+        leaf.min = minimum(leaf.min, min);
+        leaf.max = maximum(leaf.max, max);
+        return item;
+    }
+    // Otherwise the leaf moves to the end, and its old spot becomes the parent of it and a new leaf for the item.
+    // Both are added after their parent, as refit() expects.
+    const Node moved{leaf};
+    leaf.min = minimum(moved.min, min);
+    leaf.max = maximum(moved.max, max);
+    leaf.first = static_cast<GLuint>(mNodes.size());
+    leaf.count = 0;
+    mNodes.push_back(moved);
+    mNodes.push_back(added);
+    return item;
+}
+
+void BVH::clear()
+{
+    mNodes.clear();
+    mBounds.clear();
+    mOrder.clear();
+    mBuiltCost = 0.f;
+}
+
+void BVH::setBounds(GLuint item, const vec3 &min, const vec3 &max)
+{
+    mBounds[item] = Bounds{min, max};
+}
+
+bool BVH::refit()
+{
+    for (size_t i{mNodes.size()}; i-- > 0;)
+        fitNode(mNodes[i]);
+    return cost() <= mBuiltCost * 2.f;
+}
+
+bool BVH::split(GLuint nodeIndex)
+{
+    // Copied, since adding the children may move the nodes
+    const Node node{mNodes[nodeIndex]};
+    if (node.count <= 1)
+        return false;
+    // Still building, so the items are reached through mOrder
+    auto centroid = [this](GLuint item) { return (mBounds[item].min + mBounds[item].max) * 0.5f; };
+    vec3 centroidMin{Infinity, Infinity, Infinity}, centroidMax{-Infinity, -Infinity, -Infinity};
+    for (GLuint i{node.first}; i < node.first + node.count; i++) {
+        const vec3 center{centroid(mOrder[i])};
+        centroidMin = minimum(centroidMin, center);
+        centroidMax = maximum(centroidMax, center);
+    }
+    // Sort the items into bins along each axis by their centroid, and try a split between every pair of bins
+    float bestCost{Infinity};
+    int bestAxis{-1}, bestSplit{0};
+    for (int axis{0}; axis < 3; axis++) {
+        const float extent{centroidMax[axis] - centroidMin[axis]};
+        if (extent <= 0.f)
+            continue;
+        const float scale{BinCount / extent};
+        std::array<Bin, BinCount> bins;
+        for (GLuint i{node.first}; i < node.first + node.count; i++) {
+            const GLuint item{mOrder[i]};
+            const int bin{std::min(BinCount - 1, static_cast<int>((centroid(item)[axis] - centroidMin[axis]) * scale))};
+            bins[bin].grow(mBounds[item].min, mBounds[item].max);
+            bins[bin].count++;
+        }
+        std::array<float, BinCount - 1> leftCost;
+        Bin left, right;
+        for (int i{0}; i < BinCount - 1; i++) {
+            left.grow(bins[i]);
+            leftCost[i] = left.cost();
+        }
+        for (int i{BinCount - 1}; i > 0; i--) {
+            right.grow(bins[i]);
+            const float splitCost{leftCost[i - 1] + right.cost()};
+            if (splitCost < bestCost) {
+                bestCost = splitCost;
+                bestAxis = axis;
+                bestSplit = i;
+            }
+        }
+    }
+    if (bestAxis == -1) // Every centroid in the same spot
+        return false;
+    const float nodeArea{area(node.min, node.max)};
+    const float leafCost{nodeArea * node.count};
+    if (TraversalCost * nodeArea + bestCost >= leafCost && node.count <= MaxLeafSize)
+        return false;
+
+    const float scale{BinCount / (centroidMax[bestAxis] - centroidMin[bestAxis])};
+    auto first{mOrder.begin() + node.first};
+    auto middle{std::partition(first, first + node.count, [&](GLuint item) {
+        return std::min(BinCount - 1, static_cast<int>((centroid(item)[bestAxis] - centroidMin[bestAxis]) * scale)) < bestSplit;
+    })};
+    const GLuint leftCount{static_cast<GLuint>(middle - first)};
+    if (leftCount == 0 || leftCount == node.count)
+        return false;
+    Node left, right;
+    left.first = node.first;
+    left.count = leftCount;
+    right.first = node.first + leftCount;
+    right.count = node.count - leftCount;
+    fitUnsorted(left);
+    fitUnsorted(right);
+    mNodes[nodeIndex].first = static_cast<GLuint>(mNodes.size());
+    mNodes[nodeIndex].count = 0;
+    mNodes.push_back(left);
+    mNodes.push_back(right);
+    return true;
+}
+
+void BVH::fitNode(Node &node) const
+{
+    if (node.count > 0) {
+        node.min = mBounds[node.first].min;
+        node.max = mBounds[node.first].max;
+        for (GLuint i{node.first + 1}; i < node.first + node.count; i++) {
+            node.min = minimum(node.min, mBounds[i].min);
+            node.max = maximum(node.max, mBounds[i].max);
+        }
+    }
+    else {
+        const Node &left{mNodes[node.first]};
+        const Node &right{mNodes[node.first + 1]};
+        node.min = minimum(left.min, right.min);
+        node.max = maximum(left.max, right.max);
+    }
+}
+
+void BVH::fitUnsorted(Node &node) const
+{
+    node.min = mBounds[mOrder[node.first]].min;
+    node.max = mBounds[mOrder[node.first]].max;
+    for (GLuint i{node.first + 1}; i < node.first + node.count; i++) {
+        node.min = minimum(node.min, mBounds[mOrder[i]].min);
+        node.max = maximum(node.max, mBounds[mOrder[i]].max);
+    }
+}
+
+float BVH::cost() const
+{
+    float total{0.f};
+    for (const auto &node : mNodes)
+        total += area(node.min, node.max);
+    return total;
+}
@@ -0,0 +1,194 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "gltypes.h"
+#include "vector3d.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/**
+ * The BVH class is a bounding volume hierarchy over a set of boxes, used to find what a ray hits without testing every box.
+ * Items are identified by an index into the caller's own list, like in SpatialGrid.
+ * build() splits the items using the surface area heuristic, which is slow-ish but gives a good tree.
+ * It also sorts the items so that every leaf's items are next to each other, see order(),
+ * which lets the caller keep its own data in the same order and test a whole leaf at once with the gsl::simd kernels.
+ * When items move, setBounds() followed by refit() updates the boxes of the existing tree instead of building a new one.
+ * A few items can also be added to an existing tree with insert().
+ */
+class BVH {
+    using vec3 = gsl::Vector3D;
+
+public:
+    struct Bounds {
+        vec3 min;
+        vec3 max;
+    };
+    /**
+     * Build a new tree over the given boxes. Item i afterwards is bounds[order()[i]].
+     * @param bounds
+     */
+    void build(std::vector<Bounds> bounds);
+    /**
+     * Index in the list given to build() of each item, in the order they're stored in the tree.
+     * @return
+     */
+    const std::vector<GLuint> &order() const { return mOrder; }
+    /**
+     * Add an item to the tree without building it again, next to the leaf whose box grows the least.
+     * Much cheaper than build(), but the tree gets slower to search than a freshly built one the more items are inserted.
+     * @param min
+     * @param max
+     * @return the new item, which is always the last one. Its order() is the number of items before it.
+     */
+    GLuint insert(const vec3 &min, const vec3 &max);
+    /**
+     * Remove every item.
+     */
+    void clear();
+    /**
+     * Change the box of an item. The tree isn't updated until refit() is called.
+     * @param item
+     * @param min
+     * @param max
+     */
+    void setBounds(GLuint item, const vec3 &min, const vec3 &max);
+    const Bounds &bounds(GLuint item) const { return mBounds[item]; }
+    /**
+     * Recalculate every node's box from the items' current boxes, keeping the tree's layout.
+     * The tree gets slower to search the further the items move from where they were when it was built.
+     * @return false if it got bad enough that calling build() again is worth it.
+     */
+    bool refit();
+    /**
+     * Visits the items whose box is hit by the ray within maxDistance, closer nodes first.
+     * func(item, maxDistance) does the actual test against the item. It can lower maxDistance to skip everything further away
+     * (closest hit), and returns false to stop the search altogether (any hit).
+     * @param origin
+     * @param invDir 1 / direction of the ray
+     * @param maxDistance in units of the ray's direction
+     * @param func
+     */
+    template <typename Func>
+    void raycast(const vec3 &origin, const vec3 &invDir, float maxDistance, Func func) const
+    {
+        raycastLeaves(origin, invDir, maxDistance, [&func](GLuint first, GLuint count, float &distance) {
+            for (GLuint item{first}; item < first + count; item++) {
+                if (!func(item, distance))
+                    return false;
+            }
+            return true;
+        });
+    }
+    /**
+     * Same as raycast(), but func(first, count, maxDistance) is called once per leaf hit, with the leaf's items being first to first + count - 1.
+     * @param origin
+     * @param invDir 1 / direction of the ray
+     * @param maxDistance in units of the ray's direction
+     * @param func
+     */
+    template <typename Func>
+    void raycastLeaves(const vec3 &origin, const vec3 &invDir, float maxDistance, Func func) const
+    {
+        if (mNodes.empty())
+            return;
+        float entry;
+        if (!intersect(mNodes[0], origin, invDir, maxDistance, entry))
+            return;
+        std::vector<std::pair<GLuint, float>> stack;
+        stack.reserve(64);
+        stack.emplace_back(0, entry);
+        while (!stack.empty()) {
+            const auto [index, nodeEntry]{stack.back()};
+            stack.pop_back();
+            // maxDistance may have been lowered since the node was pushed
+            if (nodeEntry > maxDistance)
+                continue;
+            const Node &node{mNodes[index]};
+            if (node.count > 0) {
+                if (!func(node.first, node.count, maxDistance))
+                    return;
+                continue;
+            }
+            float leftEntry, rightEntry;
+            const bool hitLeft{intersect(mNodes[node.first], origin, invDir, maxDistance, leftEntry)};
+            const bool hitRight{intersect(mNodes[node.first + 1], origin, invDir, maxDistance, rightEntry)};
+            // The nearest child goes on top of the stack
+            if (hitLeft && hitRight) {
+                if (leftEntry < rightEntry) {
+                    stack.emplace_back(node.first + 1, rightEntry);
+                    stack.emplace_back(node.first, leftEntry);
+                }
+                else {
+                    stack.emplace_back(node.first, leftEntry);
+                    stack.emplace_back(node.first + 1, rightEntry);
+                }
+            }
+            else if (hitLeft)
+                stack.emplace_back(node.first, leftEntry);
+            else if (hitRight)
+                stack.emplace_back(node.first + 1, rightEntry);
+        }
+    }
+    size_t size() const { return mBounds.size(); }
+    bool empty() const { return mBounds.empty(); }
+
+private:
+    struct Node {
+        vec3 min;
+        vec3 max;
+        /// Leaf: its first item. Otherwise the left child, with the right child right after it.
+        GLuint first{0};
+        /// Number of items in a leaf, 0 for the other nodes
+        GLuint count{0};
+    };
+    /// Children are always stored after their parent, so going backwards visits children first
+    std::vector<Node> mNodes;
+    /// Indexed by item, in tree order
+    std::vector<Bounds> mBounds;
+    /// Item index given to build() of each item
+    std::vector<GLuint> mOrder;
+    /// Summed surface area of the nodes when the tree was built, to tell how much refit() has worn it down
+    float mBuiltCost{0.f};
+
+    /**
+     * Split a leaf in two where the surface area heuristic says it's cheapest, if splitting is cheaper than leaving it.
+     * @param nodeIndex
+     * @return true if the node was split, its children being the last two nodes
+     */
+    bool split(GLuint nodeIndex);
+    /**
+     * Recalculate a node's box from its items or children.
+     * @param node
+     */
+    void fitNode(Node &node) const;
+    /**
+     * fitNode() for a leaf while the tree is being built, when the boxes aren't in tree order yet.
+     * @param node
+     */
+    void fitUnsorted(Node &node) const;
+    /**
+     * Summed surface area of every node, the expected cost of searching the tree.
+     * @return
+     */
+    float cost() const;
+    /**
+     * Slab test between a ray and a node's box.
+     * @param entry distance where the ray enters the box, 0 if it starts inside it
+     * @return true if the ray hits the box between 0 and maxDistance
+     */
+    static bool intersect(const Node &node, const vec3 &origin, const vec3 &invDir, float maxDistance, float &entry)
+    {
+        float tmin{0.f}, tmax{maxDistance};
+        for (int axis{0}; axis < 3; axis++) {
+            const float t1{(node.min[axis] - origin[axis]) * invDir[axis]};
+            const float t2{(node.max[axis] - origin[axis]) * invDir[axis]};
+            tmin = std::max(tmin, std::min(t1, t2));
+            tmax = std::min(tmax, std::max(t1, t2));
+        }
+        entry = tmin;
+        return tmin <= tmax;
+    }
+};
+
+#endif // BVH_H
@@ -0,0 +1,14 @@
+#include "commandbuffer.h"
+#include "registry.h"
+
+GLuint CommandBuffer::create(const QString &name)
+{
+    const GLuint entityID{Registry::instance()->reserveEntity()};
+    mCommands.push_back({Op::Create, 0, entityID, [entityID, name](Registry &registry) { registry.makeReserved(entityID, name, false); }});
+    return entityID;
+}
+
+void CommandBuffer::destroy(GLuint entityID)
+{
+    mCommands.push_back({Op::Destroy, 0, entityID, [entityID](Registry &registry) { registry.removeEntity(entityID); }});
+}
@@ -0,0 +1,91 @@
+#ifndef COMMANDBUFFER_H
+#define COMMANDBUFFER_H
+
+#include "family.h"
+#include "gltypes.h"
+#include <QString>
+#include <functional>
+#include <vector>
+
+class Registry;
+/**
+ * The CommandBuffer class records structural changes (entity creation/destruction, adding/removing components)
+ * so they can be applied later in one batch, by Registry::flush().
+ * Use it instead of the Registry directly while iterating a View or Group, or from inside par_each(),
+ * since each structural change may swap components around in the pools being iterated.
+ * Every thread gets its own buffer through Registry::commands(), so recording needs no locking.
+ */
+class CommandBuffer {
+public:
+    /**
+     * What a command does, in the order they are applied by Registry::flush().
+     */
+    enum class Op {
+        Create,
+        Remove,
+        Add,
+        Destroy
+    };
+    /**
+     * One recorded change.
+     */
+    struct Command {
+        Op op;
+        /// ComponentFamily index of the pool touched by the command, used to batch commands per pool.
+        size_t type;
+        GLuint entity;
+        std::function<void(Registry &)> apply;
+    };
+
+    /**
+     * Reserves an entity ID and records its creation. Components can be added to the ID right away.
+     * Registry::flush() announces every entity created in the batch with a single entitiesCreated signal.
+     * @param name
+     * @return The entity ID the entity will have once the buffer is flushed.
+     */
+    GLuint create(const QString &name = "");
+    /**
+     * Records the destruction of an entity, as Registry::removeEntity().
+     * Registry::flush() destroys every entity recorded this way with one Registry::destroyEntities() call.
+     * @param entityID
+     */
+    void destroy(GLuint entityID);
+    /**
+     * Records a new component for an entity. The component is constructed right away from args.
+     * @param entityID
+     */
+    template <typename Type, typename... Args>
+    void add(GLuint entityID, Args... args)
+    {
+        mCommands.push_back({Op::Add, ComponentFamily::type<Type>, entityID, [entityID, component = Type{args...}](auto &registry) {
+                                 registry.template add<Type>(entityID, component);
+                             }});
+    }
+    /**
+     * Records the removal of a component from an entity. Nothing happens on flush if the entity no longer owns one.
+     * @param entityID
+     */
+    template <typename Type>
+    void remove(GLuint entityID)
+    {
+        mCommands.push_back({Op::Remove, ComponentFamily::type<Type>, entityID, [entityID](auto &registry) {
+                                 if (registry.template contains<Type>(entityID))
+                                     registry.template remove<Type>(entityID);
+                             }});
+    }
+    bool empty() const { return mCommands.empty(); }
+    /**
+     * Moves the recorded commands to the end of list, leaving the buffer empty.
+     * @param list
+     */
+    void take(std::vector<Command> &list)
+    {
+        list.insert(list.end(), std::make_move_iterator(mCommands.begin()), std::make_move_iterator(mCommands.end()));
+        mCommands.clear();
+    }
+
+private:
+    std::vector<Command> mCommands;
+};
+
+#endif // COMMANDBUFFER_H
@@ -10,12 +10,6 @@ Material::Material(cjk::Ref<Shader> shaderIn, GLuint texUnit, vec3 color, GLfloa
         shader = ResourceManager::instance()->getShader<ColorShader>();
 }
 
-AABB::AABB(bool stat) : size(vec3(1.0f, 1.0f, 1.0f))
-{
-    ResourceManager::instance()->setAABBMesh(colliderMesh);
-    isStatic = stat;
-}
-
 void ParticleEmitter::setNumParticles(size_t num)
 {
     numParticles = num;
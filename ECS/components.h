@@ -3,10 +3,13 @@
 #include "core.h"
 #include "gltypes.h"
 #include "matrix4x4.h"
+#include "quaternion.h"
 #include "sparseset.h"
 #include "vertex.h"
 #include <QColor>
-#include <queue>
+#include <array>
+#include <optional>
+#include <type_traits>
 
 #ifdef _WIN32
 #include <al.h>
@@ -37,13 +40,12 @@ struct meshData {
 };
 /**
  * @brief The Component class is the base class for all components.
+ * Only there for the vec3 alias -- it has no virtual functions, so components without heap-owning members
+ * stay trivially copyable and can be moved around the pools with memcpy.
  */
 class Component {
 public:
     using vec3 = gsl::Vector3D;
-
-    Component() = default;
-    virtual ~Component() {}
 };
 /** Entity info component struct.
 
@@ -52,8 +54,6 @@ struct EInfo : Component {
     EInfo() = default;
     EInfo(QString nameIn) : name(nameIn) {}
     QString name;
-    GLuint generation{0};
-    bool isDestroyed{false};
 };
 
 /** Component struct.
@@ -68,40 +68,35 @@ struct BillBoard : Component {
    Defines functionality for the transform component.
 */
 struct Transform : Component {
-
-    Transform()
-    {
-        modelMatrix.setToIdentity();
-        //calculate matrix from position, scale, rotation
-        translationMatrix.setToIdentity();
-        translationMatrix.translate(localPosition);
-
-        rotationMatrix.setToIdentity();
-        rotationMatrix.rotateX(localRotation.x);
-        rotationMatrix.rotateY(localRotation.y);
-        rotationMatrix.rotateZ(localRotation.z);
-
-        scaleMatrix.setToIdentity();
-        scaleMatrix.scale(localScale);
-    }
-    Transform(vec3 pos, vec3 rot = 0, vec3 newScale = 1) : Transform()
-    {
-        localPosition = pos;
-        localRotation = rot;
-        localScale = newScale;
-    }
-    bool matrixOutdated{true};
+    Transform() = default;
+    Transform(vec3 pos, vec3 rot = 0, vec3 newScale = 1)
+        : localPosition(pos), localRotation(rot), localOrientation(gsl::Quaternion::fromEuler(rot)), localScale(newScale) {}
 
     vec3 localPosition{0};
     vec3 position{0};
+    /// Euler angles in degrees as set in the editor and saved to the scene file. Rotations that don't go through
+    /// MovementSystem::setRotation(), like billboards facing the camera, only update localOrientation.
     vec3 localRotation{0};
-    vec3 rotation{0};
+    /// The rotation the matrices are built from.
+    gsl::Quaternion localOrientation;
+    /// Absolute rotation, cached whenever the world matrix is recalculated.
+    gsl::Quaternion orientation;
     vec3 localScale{1};
-    gsl::Matrix4x4 modelMatrix, translationMatrix, rotationMatrix, scaleMatrix;
-
-    std::vector<GLuint> children;
+    // The world matrix and dirty flag live in Registry::transforms(), so MovementSystem can scan them without touching the pool.
 
     int parentID = -1;
+    /// Children are kept as an intrusive list threaded through their Transforms, see Registry::getChildren().
+    int firstChild{-1};
+    int nextSibling{-1};
+    int prevSibling{-1};
+};
+/** Component struct.
+   Linear velocity in units per second. MovementSystem moves every entity owning one along with its Transform each tick,
+   all of them in one batch.
+*/
+struct Velocity : Component {
+    Velocity(vec3 v = vec3{0}) : velocity(v) {}
+    vec3 velocity;
 };
 /**
  * @brief The MaterialComponent class holds the shader, texture unit and objectcolor
@@ -286,21 +281,54 @@ struct Sound : public Component {
     vec3 velocity{0}; ///< Vector containing source velocity.
 };
 
+/** Enum class for the collision layers.
+    Each collider is on one layer, and the CollisionSystem's layer matrix decides which layers are tested against each other.
+*/
+enum class CollisionLayer { DEFAULT,
+                            LEVEL,
+                            DECORATION,
+                            TOWER,
+                            TOWER_RANGE,
+                            ENEMY,
+                            BULLET,
+                            COUNT };
+/// A layer's bit in Collision::mask and in the layer masks given to the raycasts
+constexpr GLuint layerBit(CollisionLayer layer) { return 1u << static_cast<GLuint>(layer); }
+constexpr GLuint AllLayers{~0u};
+/**
+ * Model matrix of a collider, built from its owner's Transform and the collider's own offset and size.
+ */
+struct ColliderTransform {
+    gsl::Matrix4x4 modelMatrix = gsl::Matrix4x4(true);
+    /// World space box around the collider, updated along with modelMatrix
+    gsl::Vector3D worldMin, worldMax;
+    bool matrixOutdated{true};
+    /// Set whenever modelMatrix is rebuilt, until the CollisionSystem has refit its raycast tree to the collider's new bounds
+    bool boundsOutdated{true};
+};
 /**
  * @brief The Collision component class is the base class for our various collider types.
  * Don't use on its own.
+ * Only holds the collider's shape and flags, the debug lines drawn in the editor use a mesh shared by every collider.
  */
 struct Collision : public Component {
 public:
     Collision() {}
 
+    ColliderTransform transform;
+    CollisionLayer layer{CollisionLayer::DEFAULT};
+    /// Layers this collider can collide with, as layerBit()s. Both colliders' masks have to allow a pair for it to be tested.
+    GLuint mask{AllLayers};
+    /// World position at the last collision tick, where a continuous collider's path starts
+    std::optional<gsl::Vector3D> lastPosition;
+    // The flags are kept together so they share padding
     bool trigger{false};
-    Mesh colliderMesh;
-    Transform transform;
     bool isStatic{true};
+    /// Fast colliders are tested along the whole path they moved since the last tick, so they can't pass through anything.
+    /// Only bullets against AABBs for now.
+    bool continuous{false};
+    /// Overlaps with other colliders that have it set are tracked by the CollisionSystem, see CollisionSystem::towerRanges()
     bool overlapEvent{false};
-
-    SparseSet overlappedEntities;
 };
 
 /**
@@ -310,11 +338,15 @@ struct AABB : public Collision {
     vec3 origin{0};
     vec3 size; // Half size
 
-    AABB(bool stat = true);
-    inline AABB(const vec3 &o, const vec3 &s, bool stat = true) : AABB(stat)
+    inline AABB(bool stat = true) : size(vec3(1.0f, 1.0f, 1.0f))
+    {
+        isStatic = stat;
+    }
+    inline AABB(const vec3 &o, const vec3 &s, bool stat = true, CollisionLayer layerIn = CollisionLayer::DEFAULT) : AABB(stat)
     {
         origin = o;
         size = s;
+        layer = layerIn;
     }
 };
 
@@ -335,10 +367,12 @@ struct Sphere : public Collision {
       @param Position
       @param Radius
       @param Static
+      @param Layer
     */
-    inline Sphere(const vec3 &pos, const float &r, bool stat = true) : position(pos), radius(r)
+    inline Sphere(const vec3 &pos, const float &r, bool stat = true, CollisionLayer layerIn = CollisionLayer::DEFAULT) : position(pos), radius(r)
     {
         isStatic = stat;
+        layer = layerIn;
     }
 };
 
@@ -400,6 +434,38 @@ enum class TowerStates { IDLE,
 enum class AttackType { SPLASH,
                         PHYSICAL,
                         MAGIC };
+/**
+ * @brief The EventQueue struct is a fixed-size FIFO queue of NPCevents stored inline in the component.
+ * Same interface as the std::queue it replaces. An event that is already pending isn't pushed again,
+ * the handler only reacts to the state it leaves behind (health, the end of the path).
+ * So at most one of each event is pending and the queue can't fill up and lose one.
+ */
+struct EventQueue {
+    static constexpr size_t Capacity{8};
+    static_assert(static_cast<size_t>(NPCevents::DAMAGE_TAKEN) < Capacity, "One of each event must fit in the queue");
+
+    void push(NPCevents event)
+    {
+        for (size_t i{0}; i < count; i++) {
+            if (events[(head + i) % Capacity] == event)
+                return;
+        }
+        events[(head + count++) % Capacity] = event;
+    }
+    NPCevents front() const { return events[head]; }
+    void pop()
+    {
+        head = (head + 1) % Capacity;
+        count--;
+    }
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+private:
+    std::array<NPCevents, Capacity> events{};
+    size_t head{0};
+    size_t count{0};
+};
 /** Component struct.
     Defines functionality for the AIcomponent.
 */
@@ -409,7 +475,7 @@ struct AIComponent : public Component {
     float moveSpeed;
     float pathT{0};
     NPCstates state{NPCstates::MOVE};
-    std::queue<NPCevents> notification_queue;
+    EventQueue notification_queue;
 };
 /** Component struct.
     Defines functionality for the tower component, with attributes for the buildable towers.
@@ -444,11 +510,20 @@ struct PlayerComponent : public Component {
 */
 struct Bullet : public Component {
     Bullet() {}
-    Bullet(vec3 route, int d, float s) : direction(route), damage(d), speed(s) {}
-    vec3 direction;
+    Bullet(int d) : damage(d) {}
     int damage;
     float lifeTime{3};
-    float speed;
 };
 
+// These are iterated and moved around every frame, so they must stay plain data.
+static_assert(std::is_trivially_copyable_v<Transform>);
+static_assert(std::is_trivially_copyable_v<Velocity>);
+static_assert(std::is_trivially_copyable_v<AIComponent>);
+static_assert(std::is_trivially_copyable_v<TowerComponent>);
+static_assert(std::is_trivially_copyable_v<Bullet>);
+static_assert(std::is_trivially_copyable_v<BillBoard>);
+static_assert(std::is_trivially_copyable_v<GameCamera>);
+static_assert(std::is_trivially_copyable_v<AABB>);
+static_assert(std::is_trivially_copyable_v<Sphere>);
+
 #endif // COMPONENT_H
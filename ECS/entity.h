@@ -0,0 +1,48 @@
+#ifndef ENTITY_H
+#define ENTITY_H
+
+#include "gltypes.h"
+/**
+ * The Entity class packs an entity handle into a GLuint, so handles can be used anywhere a plain entity ID was before.
+ * The low IndexBits bits are the entity's index, the slot it uses in the pools' sparse arrays.
+ * The bits above are its version, which goes up every time a destroyed entity's index is reused,
+ * so a handle kept after its entity was destroyed never aliases the entity that gets the index next.
+ * Check such handles with Registry::valid().
+ * The first entity given an index has version 0, so its handle equals its index, which keeps IDs in saved scenes the same.
+ * Handles stay below 2^31, so they also fit in Transform::parentID.
+ */
+class Entity {
+public:
+    static constexpr GLuint IndexBits{20};
+    static constexpr GLuint IndexMask{(1u << IndexBits) - 1};
+    static constexpr GLuint VersionMask{(1u << (31 - IndexBits)) - 1};
+    /// Handle no entity will ever have.
+    static constexpr GLuint Null{~0u};
+    /**
+     * Index part of a handle. Use this where an entity ID is used as an array index.
+     * @param handle
+     * @return
+     */
+    static constexpr GLuint index(GLuint handle) { return handle & IndexMask; }
+    /**
+     * Version part of a handle.
+     * @param handle
+     * @return
+     */
+    static constexpr GLuint version(GLuint handle) { return handle >> IndexBits; }
+    /**
+     * Build a handle out of an index and a version. The version wraps around once it runs out of bits.
+     * @param index
+     * @param version
+     * @return
+     */
+    static constexpr GLuint handle(GLuint index, GLuint version) { return (version & VersionMask) << IndexBits | index; }
+    /**
+     * Handle for the next entity to use the same index.
+     * @param handle
+     * @return
+     */
+    static constexpr GLuint next(GLuint handle) { return Entity::handle(index(handle), version(handle) + 1); }
+};
+
+#endif // ENTITY_H
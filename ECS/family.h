@@ -0,0 +1,41 @@
+#ifndef FAMILY_H
+#define FAMILY_H
+
+#include <bitset>
+#include <cstddef>
+/**
+ * The Family class hands out dense, zero-based integer IDs to types.
+ * Every Tag type starts its own sequence, so components and systems are numbered independently of each other.
+ * An ID is assigned the first time a type is named and stays fixed for the rest of the program,
+ * which lets the Registry keep its pools and systems in flat vectors indexed by that ID.
+ * @example Family<struct ComponentTag>::type<Transform> is the index of the Transform pool.
+ */
+template <typename Tag>
+class Family {
+    inline static std::size_t identifier{};
+
+public:
+    using family_type = std::size_t;
+    /**
+     * Unique, dense ID for the given type within this family.
+     */
+    template <typename Type>
+    inline static const family_type type = identifier++;
+    /**
+     * Number of IDs handed out so far.
+     * @return
+     */
+    static family_type size() { return identifier; }
+};
+
+/// Dense type indices for component types, used to index the Registry's pools.
+using ComponentFamily = Family<struct ComponentTag>;
+/// Dense type indices for system types, used to index the Registry's systems.
+using SystemFamily = Family<struct SystemTag>;
+
+/// Upper bound on the number of component types a Signature can tell apart.
+constexpr std::size_t MaxComponents{64};
+/// Set of component types, one bit per ComponentFamily index.
+using Signature = std::bitset<MaxComponents>;
+
+#endif // FAMILY_H
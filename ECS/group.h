@@ -1,6 +1,7 @@
 #ifndef GROUP_H
 #define GROUP_H
 #include "pool.h"
+#include "threadpool.h"
 
 /**
  * Fully owned group.
@@ -99,6 +100,35 @@ public:
         else
             return std::tuple<decltype(get<Comp>(entt))...>{get<Comp>(entt)...};
     }
+    /**
+     * Calls func(entity, Owned &...) for every entity in the group.
+     * All owned pools are sorted so that the group occupies the same leading positions in each of them,
+     * meaning the components are read straight from the packed arrays.
+     * @param func
+     */
+    template <typename Func>
+    void each(Func func) const
+    {
+        const GLuint *entity{std::get<0>(pools)->entities()};
+        auto components{std::make_tuple(std::get<Pool<Owned> *>(pools)->raw()...)};
+        for (size_t pos{*length}; pos > 0; pos--)
+            func(entity[pos - 1], std::get<Owned *>(components)[pos - 1]...);
+    }
+    /**
+     * Parallel version of each(), with the same rules as View::par_each().
+     * @param func Callable taking (GLuint entity, Owned &...).
+     * @param chunkSize Entities per chunk, 0 to let the pool decide.
+     */
+    template <typename Func>
+    void par_each(Func func, size_t chunkSize = 0) const
+    {
+        const GLuint *entity{std::get<0>(pools)->entities()};
+        auto components{std::make_tuple(std::get<Pool<Owned> *>(pools)->raw()...)};
+        ThreadPool::instance()->parallelFor(*length, chunkSize, [&](size_t first, size_t last) {
+            for (size_t pos{first}; pos < last; pos++)
+                func(entity[pos], std::get<Owned *>(components)[pos]...);
+        });
+    }
 
 private:
     Group(const size_t *extent, Pool<Owned> *... owned) : pools{owned...}, length(extent)
@@ -0,0 +1,44 @@
+#include "paircache.h"
+
+void PairCache::begin()
+{
+    if (++mTick == 0) { // Wrapped around, an old stamp could look current
+        for (auto &pair : mPairs)
+            pair.second = 0;
+        mTick = 1;
+    }
+    mEntered.clear();
+    mStayed.clear();
+    mExited.clear();
+}
+
+void PairCache::add(GLuint first, GLuint second)
+{
+    auto [pair, inserted]{mPairs.try_emplace(key(first, second), mTick)};
+    if (inserted)
+        mEntered.push_back(Pair{first, second});
+    else if (pair->second != mTick) {
+        pair->second = mTick;
+        mStayed.push_back(Pair{first, second});
+    }
+}
+
+void PairCache::end()
+{
+    for (auto pair{mPairs.begin()}; pair != mPairs.end();) {
+        if (pair->second != mTick) {
+            mExited.push_back(Pair{static_cast<GLuint>(pair->first >> 32), static_cast<GLuint>(pair->first)});
+            pair = mPairs.erase(pair);
+        }
+        else
+            ++pair;
+    }
+}
+
+void PairCache::clear()
+{
+    mPairs.clear();
+    mEntered.clear();
+    mStayed.clear();
+    mExited.clear();
+}
@@ -0,0 +1,58 @@
+#ifndef PAIRCACHE_H
+#define PAIRCACHE_H
+
+#include "gltypes.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The PairCache class remembers which pairs of entities overlapped, and turns each tick's overlaps into enter, stay and exit events.
+ * Every tick: begin(), add() every overlapping pair, then end(). The events stay available until the next begin(),
+ * so systems running later in the tick (or early in the next) can handle them all in one go.
+ * Pairs are ordered, (a, b) and (b, a) are different pairs, so the caller decides which role each entity has,
+ * e.g. a tower first and the enemy in its range second.
+ */
+class PairCache {
+public:
+    struct Pair {
+        GLuint first;
+        GLuint second;
+    };
+    /**
+     * Start a new tick, clearing the last tick's events.
+     */
+    void begin();
+    /**
+     * Report that two entities overlap this tick. Reporting the same pair more than once in a tick is fine.
+     * @param first
+     * @param second
+     */
+    void add(GLuint first, GLuint second);
+    /**
+     * Finish the tick. The pairs that weren't reported since begin() become exit events and are forgotten.
+     */
+    void end();
+    /**
+     * Forget every pair without any events, e.g. when a new scene is loaded.
+     */
+    void clear();
+    /// Pairs that started overlapping this tick
+    const std::vector<Pair> &entered() const { return mEntered; }
+    /// Pairs that overlapped last tick as well
+    const std::vector<Pair> &stayed() const { return mStayed; }
+    /// Pairs that stopped overlapping this tick, or whose entities were removed
+    const std::vector<Pair> &exited() const { return mExited; }
+    /// Number of overlapping pairs
+    size_t size() const { return mPairs.size(); }
+
+private:
+    /// Tick each pair was last reported in
+    std::unordered_map<std::uint64_t, std::uint32_t> mPairs;
+    std::uint32_t mTick{0};
+    std::vector<Pair> mEntered, mStayed, mExited;
+
+    static std::uint64_t key(GLuint first, GLuint second) { return static_cast<std::uint64_t>(first) << 32 | second; }
+};
+
+#endif // PAIRCACHE_H
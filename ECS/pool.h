@@ -3,6 +3,8 @@
 
 #include "core.h"
 #include "sparseset.h"
+#include <cstring>
+#include <type_traits>
 #include <vector>
 /**
  * The IPool class is the base Interface class for the Pool<Type> class.
@@ -18,9 +20,13 @@ public:
     virtual int find(const GLuint eID) const = 0;
     virtual bool has(const GLuint eID) const = 0;
     virtual const GLuint *entities() const = 0;
-    virtual const int &index(GLuint entityID) const = 0;
+    virtual int index(GLuint entityID) const = 0;
     virtual size_t size() const = 0;
+    virtual size_t memoryUsage() const = 0;
     virtual bool empty() const = 0;
+    virtual void reserve(size_t capacity) = 0;
+    virtual void clear() = 0;
+    virtual void retain(GLuint entityID) = 0;
     virtual iterator begin() const = 0;
     virtual iterator end() const = 0;
     /**
@@ -144,6 +150,7 @@ template <typename Type>
 /**
  * The Pool class is a wrapper containing a Sparse Set of entities (GLuint) and their components.
  * The Sparse Set serves as an index for each entity's component for quick look-up with minimal cache misses.
+ * Trivially copyable component types are swapped and removed with plain memcpy instead of going through std::swap.
  */
 class Pool : public IPool {
 public:
@@ -201,7 +208,15 @@ public:
     {
         if (has(removedEntityID)) {
             GLuint swappedEntity{mEntities.back()};
-            swap(swappedEntity, removedEntityID); // Swap the removed with the last, then pop out the last.
+            if constexpr (std::is_trivially_copyable_v<Type>) {
+                // No need to swap, the removed component can simply be overwritten by the last one.
+                Type &removed{get(removedEntityID)};
+                if (&removed != &mComponents.back())
+                    std::memcpy(&removed, &mComponents.back(), sizeof(Type));
+                mEntities.swap(swappedEntity, removedEntityID);
+            }
+            else
+                swap(swappedEntity, removedEntityID); // Swap the removed with the last, then pop out the last.
             mComponents.pop_back();
             mEntities.remove(removedEntityID, false);
         }
@@ -216,7 +231,19 @@ public:
     {
         assert(has(entityID));
         assert(has(otherEntityID));
-        std::swap(mComponents[mEntities.find(entityID)], mComponents[mEntities.find(otherEntityID)]); // Swap the components to keep the dense set up to date
+        Type &lhs{mComponents[mEntities.index(entityID)]};
+        Type &rhs{mComponents[mEntities.index(otherEntityID)]};
+        // Swap the components to keep the dense set up to date
+        if constexpr (std::is_trivially_copyable_v<Type>) {
+            if (&lhs != &rhs) {
+                alignas(Type) unsigned char temp[sizeof(Type)];
+                std::memcpy(temp, &lhs, sizeof(Type));
+                std::memcpy(&lhs, &rhs, sizeof(Type));
+                std::memcpy(&rhs, temp, sizeof(Type));
+            }
+        }
+        else
+            std::swap(lhs, rhs);
         mEntities.swap(entityID, otherEntityID);
     }
 
@@ -261,21 +288,13 @@ public:
      */
     const GLuint *entities() const override { return mEntities.entities(); }
 
-    /**
-     * Returns the sparse array containing an int "pointer" to the mEntityList and mComponentList arrays.
-     * The index location is equal to the entityID.
-     * @example The location of Entity 5 in the packed arrays can be found at mEntities.mIndices[5].
-     * Both IDs and arrays begin at 0.
-     * @return
-     */
-    const std::vector<int> &indices() { return mEntities.getIndices(); }
     /**
      * Find the location of the entityID in the Sparse Set's entity list.
-     * Can return -1, in which case the entity is not contained within.
+     * The entity must be contained in the pool, use find() otherwise.
      * @param entityID
      * @return
      */
-    const int &index(GLuint entityID) const
+    int index(GLuint entityID) const override
     {
         return mEntities.index(entityID);
     }
@@ -339,18 +358,51 @@ public:
     bool empty() const override { return mEntities.empty(); }
     /**
      * Size of the sparse array.
-     * Usually equal to the ID of the latest entity created that owns a component in this pool.
+     * Usually just above the ID of the latest entity created that owns a component in this pool.
+     * @return
+     */
+    size_t extent() const { return mEntities.extent(); }
+    /**
+     * Number of bytes currently allocated by the pool, both for the sparse set and the components.
+     * Heap memory owned by the components themselves isn't counted.
      * @return
      */
-    size_t extent() { return mEntities.extent(); }
+    size_t memoryUsage() const override
+    {
+        return mEntities.memoryUsage() + mComponents.capacity() * sizeof(Type);
+    }
+    /**
+     * Make room for the given number of components, so adding entities in bulk doesn't reallocate repeatedly.
+     * @param capacity Total number of components, including the ones already in the pool.
+     */
+    void reserve(size_t capacity) override
+    {
+        mEntities.reserve(capacity);
+        mComponents.reserve(capacity);
+    }
     /**
      * Reset the arrays to empty.
      */
-    void clear()
+    void clear() override
     {
         mEntities.clear();
         mComponents.clear();
     }
+    /**
+     * Remove every entity except the given one, without going through them one by one.
+     * @param entityID
+     */
+    void retain(GLuint entityID) override
+    {
+        if (!has(entityID)) {
+            clear();
+            return;
+        }
+        Type kept{std::move(get(entityID))};
+        clear();
+        mEntities.insert(entityID);
+        mComponents.push_back(std::move(kept));
+    }
     // Comparison operator overloads
     template <typename Type2>
     bool operator>(Pool<Type2> &other)
@@ -14,14 +14,14 @@ Registry *Registry::instance()
     return mInstance;
 }
 
-void Registry::onConstruct(const std::string &type, const GLuint entityID)
+void Registry::onConstruct(const size_t type, const GLuint entityID)
 {
     for (auto &group : mGroups) {
         if (group->ownsType(type)) {
             std::vector<IPool *> pools;
             size_t num{};
-            for (auto &poolName : group->pools) {
-                auto member = getPool(poolName);
+            for (auto &poolIndex : group->pools) {
+                auto member = getPool(poolIndex);
                 pools.push_back(member);
                 if (member->has(entityID) && !(static_cast<size_t>(member->index(entityID)) < group->owned)) {
                     num++;
@@ -38,14 +38,14 @@ void Registry::onConstruct(const std::string &type, const GLuint entityID)
     }
 }
 
-void Registry::onDestroy(const std::string &type, const GLuint entityID)
+void Registry::onDestroy(const size_t type, const GLuint entityID)
 {
     for (auto &group : mGroups) {
         if (group->ownsType(type)) {
             std::vector<IPool *> pools;
             size_t num{};
-            for (auto &poolName : group->pools) {
-                auto member = getPool(poolName);
+            for (auto &poolIndex : group->pools) {
+                auto member = getPool(poolIndex);
                 pools.push_back(member);
                 if (member->has(entityID) && static_cast<size_t>(member->index(entityID)) < group->owned) {
                     num++;
@@ -69,45 +69,206 @@ EInfo &Registry::getEntity(GLuint eID)
 
 void Registry::removeEntity(GLuint eID)
 {
-    EInfo &info{get<EInfo>(eID)};
+    destroyEntities({eID});
+}
 
-    if (info.isDestroyed)
+void Registry::destroyEntities(const std::vector<GLuint> &entities)
+{
+    std::vector<GLuint> destroyed, orphans;
+    destroyed.reserve(entities.size());
+    for (auto eID : entities) {
+        if (!valid(eID))
+            continue;
+        if (contains<Transform>(eID)) {
+            // Unlinked silently, the entitiesRemoved signal below takes the entity out of the hierarchy anyway
+            if (hasParent(eID))
+                setParent(eID, -1, true);
+            for (auto child : getChildren(eID)) {
+                setParent(child, -1, true); // Otherwise the children would be left linked to a parent that no longer exists
+                orphans.push_back(child);
+            }
+            mTransforms.remove(eID);
+        }
+        if (contains<Sound>(eID)) {
+            system<SoundSystem>()->deleteSound(get<Sound>(eID));
+        }
+        mHandles[Entity::index(eID)] = Entity::Null;
+        destroyed.push_back(eID);
+    }
+    if (destroyed.empty())
         return;
-    if (contains<Transform>(eID)) {
-        setParent(eID, -1);
+#ifdef CJK_ARCHETYPE_STORAGE
+    for (auto eID : destroyed)
+        entityDestroyed(eID);
+#else
+    removeFromGroups(destroyed);
+    for (auto &pool : mPools) {
+        if (!pool)
+            continue;
+        for (auto eID : destroyed)
+            pool->remove(eID);
+    }
+#endif
+    {
+        std::lock_guard<std::mutex> lock{mEntityMutex};
+        mAvailableIDs.insert(mAvailableIDs.end(), destroyed.begin(), destroyed.end());
     }
-    if (contains<Sound>(eID)) {
-        system<SoundSystem>()->deleteSound(get<Sound>(eID));
+    // Only the children outliving their parent moved in the hierarchy, announced before their old parent's row goes away
+    for (auto child : orphans) {
+        if (valid(child))
+            emit parentChanged(child);
     }
-    info.isDestroyed = true;
-    info.name.clear();
-    info.generation++;
+    emit entitiesRemoved(destroyed);
+}
 
-    entityDestroyed(eID); // Pass the message on to each pool
+void Registry::addToGroups(const Signature &types, const std::vector<GLuint> &entities)
+{
+    for (auto &group : mGroups) {
+        if (std::none_of(group->pools.cbegin(), group->pools.cend(), [&types](size_t poolIndex) { return types.test(poolIndex); }))
+            continue;
+        std::vector<IPool *> pools;
+        for (auto &poolIndex : group->pools)
+            pools.push_back(getPool(poolIndex));
+        for (auto entity : entities) {
+            if (std::all_of(pools.cbegin(), pools.cend(), [entity, &group](IPool *member) {
+                    return member->has(entity) && !(static_cast<size_t>(member->index(entity)) < group->owned);
+                })) {
+                const auto pos = group->owned++;
+                for (auto &pool : pools) {
+                    pool->swap(pool->entities()[pos], entity);
+                }
+            }
+        }
+    }
+}
 
-    emit entityRemoved(eID);
+void Registry::removeFromGroups(const std::vector<GLuint> &entities)
+{
+    for (auto &group : mGroups) {
+        std::vector<IPool *> pools;
+        for (auto &poolIndex : group->pools)
+            pools.push_back(getPool(poolIndex));
+        for (auto entity : entities) {
+            if (std::all_of(pools.cbegin(), pools.cend(), [entity, &group](IPool *member) {
+                    return member->has(entity) && static_cast<size_t>(member->index(entity)) < group->owned;
+                })) {
+                const auto pos = --group->owned;
+                for (auto &pool : pools) {
+                    pool->swap(pool->entities()[pos], entity);
+                }
+            }
+        }
+    }
 }
-// Might be a bottleneck here. Probably better to save the next available entity ID in a vector when an entity is destroyed
 GLuint Registry::nextAvailable()
 {
+    std::lock_guard<std::mutex> lock{mEntityMutex};
     if (mAvailableIDs.empty()) {
-        return numEntities();
+        return Entity::handle(mNextIndex++, 0);
     }
     else {
-        GLuint newID = mAvailableIDs.back();
+        // Reuse the index of a destroyed entity, under a new version
+        GLuint newID = Entity::next(mAvailableIDs.back());
         mAvailableIDs.pop_back();
         return newID;
     }
 }
 
+GLuint Registry::reserveEntity()
+{
+    return nextAvailable();
+}
+
+void Registry::makeReserved(GLuint eID, const QString &name, bool signal)
+{
+    initEntity(eID, name, signal);
+}
+
+void Registry::initEntity(GLuint eID, const QString &name, bool signal)
+{
+    const GLuint index{Entity::index(eID)};
+    if (index >= mHandles.size())
+        mHandles.resize(index + 1, Entity::Null);
+    mHandles[index] = eID;
+    add<EInfo>(eID, name);
+    if (signal)
+        emit entitiesCreated({eID});
+}
+
+CommandBuffer &Registry::commands()
+{
+    thread_local CommandBuffer *buffer{nullptr};
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock{mEntityMutex};
+        mCommandBuffers.push_back(std::make_unique<CommandBuffer>());
+        buffer = mCommandBuffers.back().get();
+    }
+    return *buffer;
+}
+
+void Registry::flush()
+{
+    std::vector<CommandBuffer::Command> commands;
+    for (auto &buffer : mCommandBuffers)
+        buffer->take(commands);
+    if (commands.empty())
+        return;
+    std::stable_sort(commands.begin(), commands.end(), [](const auto &lhs, const auto &rhs) {
+        return std::tie(lhs.op, lhs.type) < std::tie(rhs.op, rhs.type);
+    });
+    std::vector<GLuint> created;
+    std::vector<GLuint> destroyed;
+    for (auto &command : commands) {
+        if (command.op == CommandBuffer::Op::Destroy) {
+            destroyed.push_back(command.entity); // Destroyed together below
+            continue;
+        }
+        command.apply(*this);
+        if (command.op == CommandBuffer::Op::Create)
+            created.push_back(command.entity);
+    }
+    // Only announce the new entities once their components are in place
+    if (!created.empty())
+        emit entitiesCreated(created);
+    if (!destroyed.empty())
+        destroyEntities(destroyed);
+}
+
 void Registry::clearScene()
 {
-    std::vector<GLuint> entities{getPool<EInfo>()->entityList()};
-    for (auto &entity : entities) {
-        if (entity != 0) {
-            removeEntity(entity);
+    std::vector<GLuint> removed;
+    for (auto entity : getEntities()) {
+        if (entity != 0)
+            removed.push_back(entity);
+    }
+#ifdef CJK_ARCHETYPE_STORAGE
+    destroyEntities(removed);
+#else
+    for (auto eID : removed) {
+        if (contains<Sound>(eID)) {
+            system<SoundSystem>()->deleteSound(get<Sound>(eID));
         }
+        mHandles[Entity::index(eID)] = Entity::Null;
     }
+    // Entity 0 is the only one left, so every pool can simply be reset around it.
+    for (auto &pool : mPools) {
+        if (pool)
+            pool->retain(0);
+    }
+    for (auto &group : mGroups)
+        group->owned = 0;
+    addToGroups(Signature{}.set(), {0});
+    mTransforms.clear();
+    if (contains<Transform>(0)) {
+        get<Transform>(0).firstChild = -1;
+        mTransforms.add(0);
+    }
+    {
+        std::lock_guard<std::mutex> lock{mEntityMutex};
+        mAvailableIDs.insert(mAvailableIDs.end(), removed.begin(), removed.end());
+    }
+    emit entitiesRemoved(removed);
+#endif
 }
 
 GLuint Registry::duplicateEntity(GLuint dupedEntity)
@@ -115,17 +276,27 @@ GLuint Registry::duplicateEntity(GLuint dupedEntity)
     // Remember it also needs to be at the same parent level
     QString dupeName{get<EInfo>(dupedEntity).name};
     GLuint entityID{makeEntity(dupeName)};
+#ifdef CJK_ARCHETYPE_STORAGE
+    mArchetypes.clone(dupedEntity, entityID);
+#else
     for (auto &pool : mPools) {
-        if (pool.second->has(dupedEntity)) {
-            pool.second->cloneComponent(dupedEntity, entityID);
+        if (pool && pool->has(dupedEntity)) {
+            pool->cloneComponent(dupedEntity, entityID);
         }
     }
-    if (contains<Transform>(dupedEntity) && hasParent(dupedEntity)) {
-        Transform &trans{getPool<Transform>()->get(entityID)};
-        setParent(entityID, trans.parentID);
-        for (auto &child : trans.children) {
-            GLuint newChild{duplicateEntity(child)};
-            child = newChild;
+#endif
+    if (contains<Transform>(dupedEntity)) {
+        // The copied links still point into the duped entity's family
+        Transform &trans{get<Transform>(entityID)};
+        mTransforms.add(entityID);
+        const int parentID{trans.parentID};
+        trans.parentID = trans.firstChild = trans.nextSibling = trans.prevSibling = -1;
+        if (parentID != -1) {
+            setParent(entityID, parentID);
+            for (auto child : getChildren(dupedEntity)) {
+                GLuint newChild{duplicateEntity(child)};
+                setParent(newChild, entityID);
+            }
         }
     }
     return entityID;
@@ -154,7 +325,10 @@ bool Registry::hasParent(GLuint eID)
 }
 std::vector<GLuint> Registry::getChildren(GLuint eID)
 {
-    return get<Transform>(eID).children;
+    std::vector<GLuint> children;
+    for (int child{get<Transform>(eID).firstChild}; child != -1; child = get<Transform>(child).nextSibling)
+        children.push_back(static_cast<GLuint>(child));
+    return children;
 }
 
 GLuint Registry::getSelectedEntity() const
@@ -170,19 +344,30 @@ void Registry::setSelectedEntity(const GLuint selectedEntity)
 void Registry::addChild(const GLuint parentID, const GLuint childID)
 {
     auto &parent{get<Transform>(parentID)};
-    parent.children.emplace_back(childID);
-    get<Transform>(childID).matrixOutdated = true;
+    auto &child{get<Transform>(childID)};
+    child.prevSibling = -1;
+    child.nextSibling = parent.firstChild;
+    if (parent.firstChild != -1)
+        get<Transform>(parent.firstChild).prevSibling = static_cast<int>(childID);
+    parent.firstChild = static_cast<int>(childID);
+    mTransforms.markDirty(childID);
+    mTransforms.invalidateOrder();
 }
 void Registry::removeChild(const GLuint eID, const GLuint childID)
 {
-    std::vector<GLuint> &children{get<Transform>(eID).children};
-    for (auto &child : children) {
-        if (child == childID) {
-            get<Transform>(childID).matrixOutdated = true;
-            std::swap(child, children.back());
-            children.pop_back();
-        }
-    }
+    auto &parent{get<Transform>(eID)};
+    auto &child{get<Transform>(childID)};
+    if (child.prevSibling == -1 && parent.firstChild != static_cast<int>(childID))
+        return; // Not linked yet, e.g. parentID was just read from a scene file
+    if (child.prevSibling != -1)
+        get<Transform>(child.prevSibling).nextSibling = child.nextSibling;
+    else
+        parent.firstChild = child.nextSibling;
+    if (child.nextSibling != -1)
+        get<Transform>(child.nextSibling).prevSibling = child.prevSibling;
+    child.prevSibling = child.nextSibling = -1;
+    mTransforms.markDirty(childID);
+    mTransforms.invalidateOrder();
 }
 
 void Registry::updateChildParent()
@@ -197,12 +382,6 @@ void Registry::updateChildParent()
         }
     }
 }
-void Registry::newGeneration(GLuint entityID, const QString &text)
-{
-    EInfo &info{get<EInfo>(entityID)};
-    info.name = text;
-    info.isDestroyed = false;
-}
 
 PlayerComponent &Registry::getPlayer()
 {
@@ -211,34 +390,59 @@ PlayerComponent &Registry::getPlayer()
 
 bool Registry::isDestroyed(GLuint entityID)
 {
-    EInfo &info{get<EInfo>(entityID)};
-    return info.isDestroyed;
+    return !valid(entityID);
 }
 
 void Registry::makeSnapshot()
 {
-    std::map<std::string, IPool *> snapPools;
+#ifdef CJK_ARCHETYPE_STORAGE
+    mArchetypeSnapshot = mArchetypes;
+#endif
+    std::vector<IPool *> snapPools;
+    snapPools.reserve(mPools.size());
     for (auto &pool : mPools) {
-        snapPools[pool.first] = pool.second->clone();
+        snapPools.push_back(pool ? pool->clone() : nullptr);
     }
     std::vector<GroupData *> groupSnapshot;
     for (auto &group : mGroups) {
         groupSnapshot.push_back(new GroupData(*group));
     }
-    std::vector<GLuint> temp = mAvailableIDs;
-
-    mSnapshot = {temp, groupSnapshot, snapPools};
+    mSnapshot = {mHandles, groupSnapshot, snapPools};
 }
 
 void Registry::loadSnapshot()
 {
-    std::map<std::string, IPool *> tempPools;
-    std::tie(mAvailableIDs, mGroups, tempPools) = mSnapshot;
-    mPools.clear();
-    for (auto &pool : tempPools) {
-        mPools[pool.first] = std::unique_ptr<IPool>(pool.second);
+    // Newest handle of every index handed out so far. Entities made and destroyed after the snapshot
+    // bumped their versions, and reusing an older version could alias a handle that's still kept somewhere.
+    std::vector<GLuint> lastHandles{mHandles};
+    lastHandles.resize(mNextIndex, Entity::Null);
+    for (auto eID : mAvailableIDs)
+        lastHandles[Entity::index(eID)] = eID;
+
+    std::vector<IPool *> tempPools;
+    std::tie(mHandles, mGroups, tempPools) = mSnapshot;
+    {
+        std::lock_guard<std::mutex> lock{mEntityMutex};
+        mAvailableIDs.clear();
+        // Highest index first, so the lowest ones are reused first
+        for (GLuint index{static_cast<GLuint>(lastHandles.size())}; index-- > 0;) {
+            if (index < mHandles.size() && mHandles[index] != Entity::Null)
+                continue;
+            // Null if the index was reserved but never made into an entity
+            mAvailableIDs.push_back(lastHandles[index] != Entity::Null ? lastHandles[index] : Entity::handle(index, 0));
+        }
+        mNextIndex = static_cast<GLuint>(lastHandles.size());
     }
-    for (auto &transform : getPool<Transform>()->data()) {
-        transform.matrixOutdated = true;
+    mPools.clear();
+    mPools.resize(tempPools.size());
+    for (size_t index{0}; index < tempPools.size(); index++) {
+        mPools[index] = std::unique_ptr<IPool>(tempPools[index]);
     }
+#ifdef CJK_ARCHETYPE_STORAGE
+    mArchetypes = mArchetypeSnapshot;
+#endif
+    // The streams still describe the entities from before the snapshot was loaded
+    mTransforms.clear();
+    for (auto entity : view<Transform>())
+        mTransforms.add(entity);
 }
@@ -1,15 +1,19 @@
 #ifndef REGISTRY_H
 #define REGISTRY_H
 
+#include "archetype.h"
+#include "commandbuffer.h"
 #include "components.h"
+#include "family.h"
 #include "group.h"
 #include "isystem.h"
 #include "pool.h"
+#include "transformstreams.h"
 #include "view.h"
 
 #include <functional>
-#include <typeinfo>
-#include <unordered_set>
+#include <mutex>
+#include <vector>
 
 template <typename... Member>
 /**
@@ -31,21 +35,21 @@ struct GroupData {
     size_t extent;
     /**
      * Function object for checking if a pool is already owned by a Group.
-     * Checks typeid().name() against already owned pools' typenames.
+     * Compares the component type index against the indices of the already owned pools.
      */
-    bool (*ownsType)(const std::string &);
-    std::unordered_set<std::string> pools;
+    bool (*ownsType)(size_t);
+    std::vector<size_t> pools;
     size_t owned{};
 };
 class Registry : public QObject {
     Q_OBJECT
     /**
-     * Simple getter for a type's typeid name.
+     * Simple getter for a component type's index in the pool list.
      */
     template <typename Type>
-    static std::string type()
+    static size_t type()
     {
-        return typeid(Type).name();
+        return ComponentFamily::type<Type>;
     }
 
 public:
@@ -60,9 +64,13 @@ public:
      * @tparam List of the component types you want the view to contain.
      */
     template <typename... Comp>
-    View<Comp...> view()
+    auto view()
     {
+#ifdef CJK_ARCHETYPE_STORAGE
+        return ArchetypeView<Comp...>{&mArchetypes};
+#else
         return View{getPool<Comp>()...};
+#endif
     }
 
     template <typename... Owned>
@@ -72,10 +80,14 @@ public:
      * First time initialization can be somewhat expensive if done while entities exist. Create before entities are created to have the group sort them as they are created.
      * Slight performance cost to component creation in the Pools owned by a Group, however this is more than offset by the gain in performance from being able to guarantee
      * that all the components iterated by the Group will be tightly packed in memory.
+     * With CJK_ARCHETYPE_STORAGE every archetype is already tightly packed, so this returns the equivalent View.
      * @return
      */
-    Group<Owned...> group()
+    auto group()
     {
+#ifdef CJK_ARCHETYPE_STORAGE
+        return view<Owned...>();
+#else
         const auto cpools{std::make_tuple(getPool<Owned>()...)};
         const size_t extent{sizeof...(Owned)};
         GroupData *data{nullptr};
@@ -87,8 +99,8 @@ public:
         }
         if (!data) {
             data = new GroupData{sizeof...(Owned),
-                                 [](const std::string &ctype) { return ((ctype == type<Owned>()) || ...); }};
-            (data->pools.insert(type<Owned>()), ...);
+                                 [](size_t ctype) { return ((ctype == type<Owned>()) || ...); }};
+            (data->pools.push_back(type<Owned>()), ...);
             mGroups.emplace_back(std::move(data));
             // find the smallest pool to use as the sorting "master"
             const auto *cpool = std::min({static_cast<const IPool *>(std::get<Pool<Owned> *>(cpools))...}, [](const auto lhs, const auto rhs) {
@@ -97,14 +109,15 @@ public:
             // Do the initial swapping to prepare the group -- basically free if done before any entities exist
             std::for_each(cpool->entities(), cpool->entities() + cpool->size(), [cpools, data](const GLuint entity) {
                 if ((std::get<Pool<Owned> *>(cpools)->has(entity) && ...)) {
-                    if (!(std::get<0>(cpools)->index(entity) < data->owned)) {
+                    if (!(static_cast<size_t>(std::get<0>(cpools)->index(entity)) < data->owned)) {
                         const auto pos = data->owned++;
                         (std::get<Pool<Owned> *>(cpools)->swap(std::get<Pool<Owned> *>(cpools)->entities()[pos], entity), ...);
                     }
                 }
             });
         }
-        return {&data->owned, std::get<Pool<Owned> *>(cpools)...};
+        return Group<Owned...>{&data->owned, std::get<Pool<Owned> *>(cpools)...};
+#endif
     }
     /**
      * Register component type. A component must be registered before it can be used by the ECS.
@@ -112,15 +125,19 @@ public:
     template <typename Type>
     void registerComponent()
     {
-        std::string typeName{typeid(Type).name()};
+#ifndef CJK_ARCHETYPE_STORAGE // Archetype columns are created the first time a component type is added
+        const size_t index{type<Type>()};
+        if (index >= mPools.size())
+            mPools.resize(index + 1);
 
-        if (mPools.find(typeName) != mPools.end()) {
+        if (mPools[index]) {
             return;
         }
         else {
-            // Create a ComponentArray pointer and add it to the component arrays map
-            mPools.emplace(typeName, std::make_unique<Pool<Type>>());
+            // Create a ComponentArray pointer and put it in the slot reserved for its type
+            mPools[index] = std::make_unique<Pool<Type>>();
         }
+#endif
     }
     /**
      * Register a system with the ECS. Not strictly required, but will allow you to use the registry to get a reference to the system.
@@ -128,15 +145,17 @@ public:
     template <typename Type, class... Args>
     cjk::Ref<Type> registerSystem(Args... args)
     {
-        std::string typeName{typeid(Type).name()};
+        const size_t index{SystemFamily::type<Type>};
+        if (index >= mSystems.size())
+            mSystems.resize(index + 1);
 
-        if (mSystems.find(typeName) != mSystems.end() && mSystems[typeName]) {
+        if (mSystems[index]) {
             return system<Type>();
         }
         else {
-            // Create a ComponentArray pointer and add it to the component arrays map
+            // Create the system and put it in the slot reserved for its type
             cjk::Ref<Type> newSystem = std::make_shared<Type>(args...);
-            mSystems.insert({typeName, newSystem});
+            mSystems[index] = newSystem;
             return newSystem;
         }
     }
@@ -150,17 +169,72 @@ public:
     GLuint makeEntity(const QString &name = "", bool signal = true)
     {
         GLuint eID{nextAvailable()};
-        if (contains<EInfo>(eID)) {
-            newGeneration(eID, name);
-        }
-        else
-            add<EInfo>(eID, name);
-        if (signal)
-            emit entityCreated(eID);
+        initEntity(eID, name, signal);
         if constexpr (sizeof...(Component) > 0)
             (add<Component>(eID), ...);
         return eID;
     }
+    /**
+     * Make several entities at once, each with default state components of the given types.
+     * Reserves room in the pools up front, sorts the new entities into Groups in one pass per Group,
+     * and emits a single entitiesCreated signal instead of one per entity.
+     * @param count Number of entities to make.
+     * @param name Name given to every one of them.
+     * @return The new entity IDs.
+     */
+    template <typename... Component>
+    std::vector<GLuint> createEntities(size_t count, const QString &name = "")
+    {
+        std::vector<GLuint> entities;
+        entities.reserve(count);
+#ifdef CJK_ARCHETYPE_STORAGE
+        for (size_t i{0}; i < count; i++) {
+            entities.push_back(nextAvailable());
+            initEntity(entities.back(), name, false);
+            (add<Component>(entities.back()), ...);
+        }
+#else
+        getPool<EInfo>()->reserve(getPool<EInfo>()->size() + count);
+        (getPool<Component>()->reserve(getPool<Component>()->size() + count), ...);
+        for (size_t i{0}; i < count; i++) {
+            entities.push_back(nextAvailable());
+            initEntity(entities.back(), name, false);
+            (getPool<Component>()->add(entities.back()), ...);
+            if constexpr ((std::is_same_v<Component, Transform> || ...))
+                mTransforms.add(entities.back());
+        }
+        Signature types;
+        (types.set(type<Component>()), ...);
+        addToGroups(types, entities);
+#endif
+        emit entitiesCreated(entities);
+        return entities;
+    }
+    /**
+     * Reserves an entity ID without creating the entity, for use with CommandBuffer::create().
+     * The ID won't be handed out again, and isn't valid() until the entity is created with makeReserved().
+     * Thread-safe.
+     * @return
+     */
+    GLuint reserveEntity();
+    /**
+     * Creates an entity with an ID given by reserveEntity().
+     * @param eID
+     * @param name
+     */
+    void makeReserved(GLuint eID, const QString &name, bool signal = true);
+    /**
+     * The calling thread's CommandBuffer, for recording structural changes during iteration.
+     * @return
+     */
+    CommandBuffer &commands();
+    /**
+     * Applies every command recorded in every thread's CommandBuffer.
+     * Creations are applied first and destructions last, as one destroyEntities() batch. Component removals and additions in between are
+     * grouped by pool, so each pool is worked on in one go.
+     * Must be called at a sync point, when no thread is recording commands or iterating the pools.
+     */
+    void flush();
     /**
      * Adds an entity and its new component to a pool of that type.
      * Entity is equivalent to Component in this case, since a pool won't contain the entity if the entity doesn't have the component.
@@ -172,10 +246,16 @@ public:
     template <typename Type, typename... Args>
     Type &add(const GLuint entityID, Args... args)
     {
+#ifdef CJK_ARCHETYPE_STORAGE
+        Type &component{mArchetypes.add<Type>(entityID, args...)};
+#else
         // Add a component to the array for an entity
         Type &component{getPool<Type>()->add(entityID, args...)};
 
         onConstruct<Type>(entityID);
+#endif
+        if constexpr (std::is_same_v<Type, Transform>)
+            mTransforms.add(entityID);
         return component;
     }
     template <typename Type>
@@ -191,8 +271,8 @@ public:
             if (group->ownsType(type<Type>())) {
                 std::vector<IPool *> pools;
                 size_t num{};
-                for (auto &poolName : group->pools) {
-                    auto member = getPool(poolName);
+                for (auto &poolIndex : group->pools) {
+                    auto member = getPool(poolIndex);
                     pools.push_back(member);
                     if (member->has(entityID) && !(static_cast<size_t>(member->index(entityID)) < group->owned)) {
                         num++;
@@ -208,7 +288,7 @@ public:
             }
         }
     }
-    void onConstruct(const std::string &type, const GLuint entityID);
+    void onConstruct(const size_t type, const GLuint entityID);
 
     /**
      * Remove a component of type Type from the entity with entityID.
@@ -216,12 +296,19 @@ public:
     template <typename Type>
     void remove(GLuint entityID)
     {
+#ifdef CJK_ARCHETYPE_STORAGE
+        mArchetypes.remove<Type>(entityID);
+#else
         onDestroy<Type>(entityID);
 
         // Remove a component from the array for an entity
         getPool<Type>()->remove(entityID);
+#endif
+        if constexpr (std::is_same_v<Type, Transform>)
+            mTransforms.remove(entityID);
+        emit componentRemoved(entityID, type<Type>());
     }
-    void onDestroy(const std::string &type, const GLuint entityID);
+    void onDestroy(const size_t type, const GLuint entityID);
     template <typename Type>
     /**
      * Called when an entity is destroyed.
@@ -237,8 +324,8 @@ public:
                 if (member->has(entityID) && static_cast<size_t>(member->index(entityID)) < group->owned) {
                     group->owned--;
                 }
-                for (auto &poolName : group->pools) {
-                    auto member = getPool(poolName);
+                for (auto &poolIndex : group->pools) {
+                    auto member = getPool(poolIndex);
                     if (member->has(entityID) && static_cast<size_t>(member->index(entityID)) < group->owned) {
                         const auto pos = group->owned;
                         member->swap(member->entities()[pos], entityID);
@@ -254,8 +341,12 @@ public:
     template <typename Type>
     Type &get(GLuint entityID)
     {
+#ifdef CJK_ARCHETYPE_STORAGE
+        return mArchetypes.get<Type>(entityID);
+#else
         // Get a reference to a component from the array for an entity
         return getPool<Type>()->get(entityID);
+#endif
     }
     template <typename... Type>
     /**
@@ -271,16 +362,6 @@ public:
         else
             return std::tuple<decltype(getSystem<Type>())...>{getSystem<Type>()...};
     }
-    /**
-     * Get a reference to the last component in the Pool of that Type.
-     * Not guaranteed to be the last created component, due to how Groups may sort their pools.
-     */
-    template <typename Type>
-    Type &getLastComponent()
-    {
-        // Get a reference to a component from the array for an entity
-        return getPool<Type>()->back();
-    }
     /**
      * Called when an entity is removed from the game.
      * Iterates through all the Pools, and if they contain a component owned by entityID, delete and re-arrange the Pool.
@@ -288,20 +369,21 @@ public:
      */
     void entityDestroyed(GLuint entityID)
     {
+#ifdef CJK_ARCHETYPE_STORAGE
+        mArchetypes.strip(entityID, Signature{});
+#else
         // Notify each component array that an entity has been destroyed.
         // If it has a component for that entity, it will remove it.
-        for (auto &pool : mPools) {
-            onDestroy(pool.first, entityID);
+        for (size_t index{0}; index < mPools.size(); index++) {
+            if (mPools[index])
+                onDestroy(index, entityID);
         }
-        for (auto &pool : mPools) {
-            if (pool.first == typeid(EInfo).name()) {
-                mAvailableIDs.push_back(entityID);
-                continue;
-            }
-            if (pool.second->has(entityID)) {
-                pool.second->remove(entityID);
+        for (size_t index{0}; index < mPools.size(); index++) {
+            if (mPools[index] && mPools[index]->has(entityID)) {
+                mPools[index]->remove(entityID);
             }
         }
+#endif
     }
     /**
      * Checks if an entity owns the given component types.
@@ -309,8 +391,12 @@ public:
     template <typename... Type>
     bool contains(GLuint eID)
     {
+#ifdef CJK_ARCHETYPE_STORAGE
+        return mArchetypes.contains(eID, ArchetypeStorage::signature<Type...>());
+#else
         [[maybe_unused]] const auto cpools{std::make_tuple(getPool<Type>()...)};
         return ((std::get<Pool<Type> *>(cpools) ? std::get<Pool<Type> *>(cpools)->has(eID) : false) && ...);
+#endif
     }
 
     /**
@@ -324,7 +410,14 @@ public:
      * All entities are guaranteed to have the EInfo component.
      * @return
      */
-    const std::vector<GLuint> getEntities() { return getPool<EInfo>()->entityList(); }
+    const std::vector<GLuint> getEntities()
+    {
+#ifdef CJK_ARCHETYPE_STORAGE
+        return mArchetypes.entities(ArchetypeStorage::signature<EInfo>());
+#else
+        return getPool<EInfo>()->entityList();
+#endif
+    }
     /**
     * Get a pointer to the entity with the specified ID.
     * @param eID
@@ -337,23 +430,55 @@ public:
     * @param eID - entityID
     */
     void removeEntity(GLuint eID);
+    /**
+     * Destroy several entities at once.
+     * Each pool and Group is gone through once for the whole batch, and a single entitiesRemoved signal is emitted.
+     * parentChanged is only emitted for the children left behind by a destroyed parent.
+     * Entities already destroyed are skipped.
+     * @param entities
+     */
+    void destroyEntities(const std::vector<GLuint> &entities);
     /**
      * Total number of entities in existence.
      * @return
      */
     GLuint numEntities()
     {
-        return getPool<EInfo>()->entityList().size();
+#ifdef CJK_ARCHETYPE_STORAGE
+        return mArchetypes.count(ArchetypeStorage::signature<EInfo>());
+#else
+        return getPool<EInfo>()->size();
+#endif
+    }
+    /**
+     * Number of bytes allocated by every registered Pool, or by the archetype tables when built with CJK_ARCHETYPE_STORAGE.
+     * Useful for checking the footprint of large scenes.
+     * @return
+     */
+    size_t memoryUsage() const
+    {
+#ifdef CJK_ARCHETYPE_STORAGE
+        return mArchetypes.memoryUsage();
+#else
+        size_t bytes{0};
+        for (auto &pool : mPools) {
+            if (pool)
+                bytes += pool->memoryUsage();
+        }
+        return bytes;
+#endif
     }
     /**
      * Get the next available ID.
-     * In a scenario with no destroyed IDs, this will simply return the number of entities + 1.
-     * Destroyed entities give up their ID for use with a new entity. This avoids unnecessary bloating.
+     * In a scenario with no destroyed IDs, this will simply return the next unused index, at version 0.
+     * Destroyed entities give up their index for use with a new entity, which gets the next version of the handle.
+     * This avoids unnecessary bloating without letting old handles alias the new entity.
      * @return
      */
     GLuint nextAvailable();
     /**
-     * Simply calls removeEntity() on every entity in the scene.
+     * Removes every entity in the scene.
+     * Resets each pool in one go rather than removing the entities one by one.
      */
     void clearScene();
     /**
@@ -366,6 +491,7 @@ public:
     void makeSnapshot();
     /**
      * Loads the snapshot taken by makeSnapshot().
+     * Every index the snapshot doesn't use goes back on the free list, under the last version it was given out with.
      */
     void loadSnapshot();
     /**
@@ -412,7 +538,31 @@ public:
      */
     GLuint getSelectedEntity() const;
     /**
-     * Check if an entity is destroyed and its ID waiting to be reassigned.
+     * Check if an entity handle refers to an entity that still exists.
+     * Doesn't touch any pool, so it's cheap enough to call on every stored handle, like TowerComponent::targetID, before use.
+     * @param entityID
+     * @return false if the entity was destroyed, even if its index has since been reused by another entity.
+     */
+    bool valid(GLuint entityID) const
+    {
+        const GLuint index{Entity::index(entityID)};
+        return index < mHandles.size() && mHandles[index] == entityID;
+    }
+    /**
+     * Handle of the entity currently using an index.
+     * @param index
+     * @return Entity::Null if no entity is using the index.
+     */
+    GLuint handle(GLuint index) const { return index < mHandles.size() ? mHandles[index] : Entity::Null; }
+    /**
+     * World matrices and dirty flags of every Transform, kept outside the Transform pool.
+     * Use markDirty() after changing a Transform's local values so MovementSystem recalculates its world matrix.
+     * @return
+     */
+    TransformStreams &transforms() { return mTransforms; }
+    const TransformStreams &transforms() const { return mTransforms; }
+    /**
+     * Check if an entity is destroyed. Same as !valid(entityID), kept for older call sites.
      * @param entityID
      * @return
      */
@@ -428,26 +578,50 @@ public slots:
     void setSelectedEntity(const GLuint selectedEntity);
 
 signals:
-    void entityCreated(GLuint eID);
-    void entityRemoved(GLuint eID);
+    void entitiesCreated(const std::vector<GLuint> &entities);
+    void entitiesRemoved(const std::vector<GLuint> &entities);
+    /// A component was removed from an entity that's still around, componentType being its ComponentFamily index.
+    void componentRemoved(GLuint eID, size_t componentType);
     void parentChanged(GLuint childID);
     void poolChanged(IPool *pool);
     void nameChanged(GLuint eID);
 
 private:
     static Registry *mInstance;
-    /// Contains the Pools for every registered component type.
-    std::map<std::string, cjk::Scope<IPool>> mPools{};
-    /// Contains every registered system.
-    std::map<std::string, cjk::Ref<ISystem>> mSystems{};
-    /// List of all the entityIDs waiting to be reassigned.
-    std::vector<uint> mAvailableIDs;
-    /**
-     * Give an EInfo component to a new entity
-     * @param id
-     * @param text
-     */
-    void newGeneration(GLuint id, const QString &text);
+    /// Contains the Pools for every registered component type, indexed by ComponentFamily type index. Unregistered types hold nullptr.
+    std::vector<cjk::Scope<IPool>> mPools{};
+    /// Contains every registered system, indexed by SystemFamily type index.
+    std::vector<cjk::Ref<ISystem>> mSystems{};
+    /// Handles of destroyed entities whose index is waiting to be reassigned, under a new version.
+    std::vector<GLuint> mAvailableIDs;
+    /// Handle of the entity currently using each index, or Entity::Null if there is none.
+    std::vector<GLuint> mHandles;
+    /// Next index never handed out before.
+    GLuint mNextIndex{0};
+    /// Hot Transform data, see transforms().
+    TransformStreams mTransforms;
+    /**
+     * Make an entity's handle valid and give it its EInfo component.
+     * @param eID
+     * @param name
+     * @param signal Emit entitiesCreated if true.
+     */
+    void initEntity(GLuint eID, const QString &name, bool signal);
+    /**
+     * Moves newly made entities into the Groups owning any of the given component types.
+     * @param types
+     * @param entities
+     */
+    void addToGroups(const Signature &types, const std::vector<GLuint> &entities);
+    /**
+     * Moves entities about to be destroyed out of every Group they're part of.
+     * @param entities
+     */
+    void removeFromGroups(const std::vector<GLuint> &entities);
+    /// Guards mAvailableIDs, mNextIndex and mCommandBuffers against threads recording commands.
+    std::mutex mEntityMutex;
+    /// Every thread's CommandBuffer.
+    std::vector<cjk::Scope<CommandBuffer>> mCommandBuffers;
     /// List of every existing Group.
     std::vector<GroupData *> mGroups{};
     /// Current entity selected in the GUI.
@@ -455,7 +629,13 @@ private:
     PlayerComponent player;
     ParticleEmitter particleEmitter;
     /// Snapshot containing relevant data for use when hitting Play/Stop in the editor.
-    std::tuple<std::vector<GLuint>, std::vector<GroupData *>, std::map<std::string, IPool *>> mSnapshot;
+    std::tuple<std::vector<GLuint>, std::vector<GroupData *>, std::vector<IPool *>> mSnapshot;
+#ifdef CJK_ARCHETYPE_STORAGE
+    /// Table-per-signature component storage, replaces mPools and mGroups.
+    ArchetypeStorage mArchetypes;
+    /// Copy of mArchetypes taken by makeSnapshot().
+    ArchetypeStorage mArchetypeSnapshot;
+#endif
 
     template <typename Type>
     /**
@@ -464,28 +644,33 @@ private:
      */
     cjk::Ref<Type> getSystem()
     {
-        std::string typeName{type<Type>()};
-        return std::static_pointer_cast<Type>(mSystems[typeName]);
+        const size_t index{SystemFamily::type<Type>};
+        if (index >= mSystems.size())
+            return nullptr;
+        return std::static_pointer_cast<Type>(mSystems[index]);
     }
     /**
-     * Return the Pool with the given typename.
+     * Return the Pool with the given type index.
      * @param type
      * @return
      */
-    IPool *getPool(const std::string &type)
+    IPool *getPool(const size_t type)
     {
         return mPools[type].get();
     }
     // Convenience function to get the statically casted pointer to the Pool of type Type.
     template <typename Type>
     /**
-     * Casts a Pool to the correct type according to its typename.
+     * Casts a Pool to the correct type according to its type index.
+     * Returns nullptr if the component type was never registered.
      * @return
      */
     Pool<Type> *getPool()
     {
-        std::string typeName{type<Type>()};
-        return static_cast<Pool<Type> *>(mPools[typeName].get());
+        const size_t index{type<Type>()};
+        if (index >= mPools.size())
+            return nullptr;
+        return static_cast<Pool<Type> *>(mPools[index].get());
     }
 };
 
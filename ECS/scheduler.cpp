@@ -0,0 +1,137 @@
+#include "scheduler.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+void Scheduler::add(const QString &name, cjk::Ref<ISystem> system, std::function<void(DeltaTime)> stage, Mode mode)
+{
+    mStages.push_back(Stage{name, system, stage, mode});
+}
+
+void Scheduler::addFixed(const QString &name, cjk::Ref<ISystem> system, std::function<void(DeltaTime)> stage)
+{
+    mStages.push_back(Stage{name, system, stage, Mode::PlayOnly, true});
+}
+
+void Scheduler::run(DeltaTime deltaTime, bool playing)
+{
+    std::vector<Stage *> fixed, active;
+    for (auto &stage : mStages) {
+        stage.time = 0;
+        if (stage.fixed)
+            fixed.push_back(&stage);
+        else if (stage.mode == Mode::Always || (stage.mode == Mode::PlayOnly) == playing)
+            active.push_back(&stage);
+    }
+    if (playing) {
+        mAccumulator += deltaTime;
+        int ticks{0};
+        for (; mAccumulator >= mTickLength && ticks < mMaxTicks; ticks++) {
+            runGraph(fixed, mTickLength);
+            mAccumulator -= mTickLength;
+            mTicked = true;
+        }
+        if (mAccumulator >= mTickLength) // Too far behind to catch up, drop the whole ticks left
+            mAccumulator = std::fmod(mAccumulator, mTickLength);
+        mAlpha = mTicked ? mAccumulator / mTickLength : 1.f;
+    }
+    else {
+        mAccumulator = 0;
+        mAlpha = 1.f;
+        mTicked = false;
+    }
+    runGraph(active, deltaTime);
+}
+
+void Scheduler::setTickRate(float ticksPerSecond)
+{
+    mTickLength = 1.f / std::max(ticksPerSecond, 1.f);
+}
+
+void Scheduler::setMaxTicksPerFrame(int ticks)
+{
+    mMaxTicks = std::max(ticks, 1);
+}
+
+void Scheduler::runGraph(const std::vector<Stage *> &active, DeltaTime deltaTime)
+{
+    // Build this frame's graph. Edges only go from earlier to later stages, so it can't have cycles.
+    const size_t count{active.size()};
+    std::vector<std::vector<size_t>> dependents(count);
+    std::vector<std::atomic<size_t>> waiting(count);
+    for (size_t later{0}; later < count; later++) {
+        waiting[later] = 0;
+        for (size_t earlier{0}; earlier < later; earlier++) {
+            if (conflicts(*active[earlier], *active[later])) {
+                dependents[earlier].push_back(later);
+                waiting[later]++;
+            }
+        }
+    }
+
+    ThreadPool *pool{ThreadPool::instance()};
+    std::atomic<size_t> remaining{count};
+    std::mutex contextMutex;
+    std::deque<size_t> contextReady; // Stages waiting for the calling thread
+    std::function<void(size_t)> launch;
+    auto execute = [&](size_t index) {
+        Stage &stage{*active[index]};
+        const auto start{std::chrono::steady_clock::now()};
+        stage.run(deltaTime);
+        stage.time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); // Fixed stages add up every tick
+        for (size_t dependent : dependents[index]) {
+            if (--waiting[dependent] == 0)
+                launch(dependent);
+        }
+        remaining--;
+    };
+    launch = [&](size_t index) {
+        if (active[index]->system->contextThread()) {
+            std::lock_guard<std::mutex> lock{contextMutex};
+            contextReady.push_back(index);
+        }
+        else
+            pool->submit([&execute, index] { execute(index); });
+    };
+    for (size_t index{0}; index < count; index++) {
+        if (waiting[index] == 0)
+            launch(index);
+    }
+    while (remaining > 0) {
+        std::optional<size_t> next;
+        {
+            std::lock_guard<std::mutex> lock{contextMutex};
+            if (!contextReady.empty()) {
+                next = contextReady.front();
+                contextReady.pop_front();
+            }
+        }
+        if (next)
+            execute(*next);
+        else if (!pool->help())
+            std::this_thread::yield();
+    }
+}
+
+std::vector<std::pair<QString, double>> Scheduler::timings() const
+{
+    std::vector<std::pair<QString, double>> times;
+    for (const auto &stage : mStages)
+        times.emplace_back(stage.name, stage.time);
+    return times;
+}
+
+bool Scheduler::conflicts(const Stage &lhs, const Stage &rhs)
+{
+    if (lhs.system == rhs.system || lhs.system->structural() || rhs.system->structural())
+        return true;
+    const ISystem &a{*lhs.system};
+    const ISystem &b{*rhs.system};
+    return (a.writes() & (b.reads() | b.writes())).any() || (b.writes() & a.reads()).any();
+}
@@ -0,0 +1,111 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "core.h"
+#include "isystem.h"
+#include <QString>
+#include <functional>
+#include <vector>
+
+/**
+ * The Scheduler class runs the systems' update functions every frame, as stages.
+ * Each frame the active stages are turned into a dependency graph: a stage waits for every stage added
+ * before it that writes a component type it reads or writes, or that reads a type it writes.
+ * Stages of the same system, and stages of structural systems, always wait for each other.
+ * Stages without dependencies between them run at the same time on the ThreadPool,
+ * except stages of context thread systems (OpenGL, Qt) which always run on the calling thread.
+ * The order stages are added in is therefore the order conflicting stages run in.
+ *
+ * Simulation stages can instead be added with addFixed(), which runs them at a fixed tick rate while the game is playing,
+ * so the simulation behaves the same and costs the same no matter the frame rate.
+ * Each frame the elapsed time is added to an accumulator and spent in whole ticks, before the per frame stages run.
+ * The time left over is carried to the next frame, and alpha() tells how far the frame is between the last two ticks,
+ * so the renderer can blend between them instead of showing the simulation stutter.
+ */
+class Scheduler {
+public:
+    /**
+     * When a stage should run.
+     */
+    enum class Mode {
+        Always,
+        EditorOnly, ///< While stopped or paused
+        PlayOnly
+    };
+    /**
+     * Adds a stage belonging to a system.
+     * The stage uses the system's declared component access.
+     * @param name Name shown by timings().
+     * @param system
+     * @param stage Function doing the work, usually a lambda calling one of the system's update functions.
+     * @param mode
+     */
+    void add(const QString &name, cjk::Ref<ISystem> system, std::function<void(DeltaTime)> stage, Mode mode = Mode::Always);
+    /**
+     * Adds a stage run once per tick while the game is playing, with the tick length as its delta time.
+     * Fixed stages are ordered among themselves the same way as the per frame stages.
+     * @param name Name shown by timings().
+     * @param system
+     * @param stage
+     */
+    void addFixed(const QString &name, cjk::Ref<ISystem> system, std::function<void(DeltaTime)> stage);
+    /**
+     * Runs the ticks due since the last frame, then every per frame stage active in the current mode,
+     * returning once all of them are done.
+     * @param deltaTime Time since the last frame.
+     * @param playing True while the game is playing and not paused.
+     */
+    void run(DeltaTime deltaTime, bool playing);
+    /**
+     * Number of fixed ticks per second.
+     * @param ticksPerSecond
+     */
+    void setTickRate(float ticksPerSecond);
+    float tickRate() const { return 1.f / mTickLength; }
+    /**
+     * Most ticks run in one frame. If the simulation falls further behind than this, e.g. after a long hitch,
+     * the rest of the time is dropped rather than making the next frame even slower.
+     * @param ticks
+     */
+    void setMaxTicksPerFrame(int ticks);
+    int maxTicksPerFrame() const { return mMaxTicks; }
+    /**
+     * How far the current frame is between the last tick and the next one, from 0 to 1.
+     * Always 1 when not playing, or before the first tick, since there's no earlier state to blend from.
+     * @return
+     */
+    float alpha() const { return mAlpha; }
+    /**
+     * Time spent in each stage during the last frame, in milliseconds. Fixed stages add up all of the frame's ticks.
+     * @return
+     */
+    std::vector<std::pair<QString, double>> timings() const;
+
+private:
+    struct Stage {
+        QString name;
+        cjk::Ref<ISystem> system;
+        std::function<void(DeltaTime)> run;
+        Mode mode;
+        bool fixed{false};
+        double time{0};
+    };
+    std::vector<Stage> mStages;
+
+    float mTickLength{1.f / 60.f};
+    int mMaxTicks{5};
+    float mAccumulator{0};
+    float mAlpha{1};
+    bool mTicked{false}; ///< Whether a tick has run since the game started playing
+
+    /**
+     * Runs the given stages as a dependency graph, returning once all of them are done.
+     */
+    void runGraph(const std::vector<Stage *> &active, DeltaTime deltaTime);
+    /**
+     * Whether two stages touch the same data in a way that stops them from running at the same time.
+     */
+    static bool conflicts(const Stage &lhs, const Stage &rhs);
+};
+
+#endif // SCHEDULER_H
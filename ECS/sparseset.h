@@ -1,22 +1,24 @@
 #ifndef SPARSESET_H
 #define SPARSESET_H
+#include "entity.h"
 #include "gltypes.h"
+#include <cstddef>
 #include <vector>
 /**
  * The SparseSet class is a custom implementation of the concept commonly called Sparse (or Dense) Set.
+ * The sparse array is split into fixed-size pages that are only allocated once an entity in their range is inserted,
+ * and released again when the last entity in the page is removed.
+ * This keeps the memory cost proportional to the entities actually contained rather than to the largest entityID ever seen.
+ * The sparse array is indexed by the index bits of the entity handle, while the entity list keeps the full handle,
+ * so a stale handle to a destroyed entity is never mistaken for the entity now using its index.
  */
 class SparseSet {
+    /// Number of entityIDs covered by one page of the sparse array. Must be a power of two.
+    static constexpr size_t PageSize{1024};
+    /// Contiguous chunk of the sparse array. An empty vector means the page isn't allocated.
+    using Page = std::vector<int>;
+
 public:
-    /**
-     * Pads the mIndex vector to make room for an entityID larger than the current size of the index.
-     * @param entityID - ID of the entity to be added.
-     */
-    void pad(GLuint entityID)
-    {
-        for (size_t i{mIndex.size()}; i < (size_t)entityID; i++) {
-            mIndex.push_back(-1);
-        }
-    }
     /**
      * Find an entity's position in the sparse set's list
      * @param eID
@@ -24,8 +26,12 @@ public:
      */
     int find(const GLuint eID) const
     {
-        if (eID < mIndex.size())
-            return mIndex[eID];
+        const size_t pos{page(eID)};
+        if (pos < mPages.size() && !mPages[pos].empty()) {
+            const int index{mPages[pos][offset(eID)]};
+            if (index != -1 && mList[index] == eID) // Same index, but a different version of the entity
+                return index;
+        }
         return -1;
     }
     /**
@@ -46,13 +52,25 @@ public:
     size_t size() const { return mList.size(); }
     bool empty() const { return mList.empty(); }
     /**
-     * Size of the sparse array.
-     * Usually equal to the ID of the latest entity created that owns a component in this pool.
+     * Size of the sparse array, rounded up to a whole number of pages.
+     * Usually just above the ID of the latest entity created that owns a component in this pool.
      * @return
      */
-    size_t extent() { return mIndex.size(); }
+    size_t extent() const { return mPages.size() * PageSize; }
+    /**
+     * Number of bytes currently allocated by the sparse set, including the entity list and every live page.
+     * @return
+     */
+    size_t memoryUsage() const
+    {
+        size_t bytes{mPages.capacity() * sizeof(Page) + mPageCount.capacity() * sizeof(GLuint) + mList.capacity() * sizeof(GLuint)};
+        for (const auto &sparse : mPages)
+            bytes += sparse.capacity() * sizeof(int);
+        return bytes;
+    }
     /**
      * Remove an entity from the Sparse Set.
+     * Releases the entity's page if it was the last entity in it.
      * @param removedEntityID
      * @param noPool If used as a pure sparse set, this should be true. Will cause the Sparse Set to swap before removal.
      */
@@ -62,16 +80,26 @@ public:
             swap(back(), removedEntityID); // Swap the removed with the last, then pop out the last.
         }
         mList.pop_back();
-        mIndex[removedEntityID] = -1; // Set entity location to an invalid value.
-        if (mList.empty())
-            mList.clear();
+        slot(removedEntityID) = -1; // Set entity location to an invalid value.
+        const size_t pos{page(removedEntityID)};
+        if (--mPageCount[pos] == 0)
+            Page().swap(mPages[pos]); // Give the memory back instead of keeping a page full of -1
+    }
+    /**
+     * Make room for the given number of entities in the entity list.
+     * @param capacity
+     */
+    void reserve(size_t capacity)
+    {
+        mList.reserve(capacity);
     }
     /**
      * Reset the arrays to empty.
      */
     void clear()
     {
-        mIndex.clear();
+        mPages.clear();
+        mPageCount.clear();
         mList.clear();
     }
     /**
@@ -94,12 +122,13 @@ public:
     }
     /**
      * Returns the index location to mList for the given entityID.
+     * The entity must be contained in the set, use find() otherwise.
      * @param entityID
      * @return
      */
-    const int &index(GLuint entityID) const
+    int index(GLuint entityID) const
     {
-        return mIndex[entityID];
+        return mPages[page(entityID)][offset(entityID)];
     }
     /**
      * Returns a read-write reference to the last element in mList.
@@ -116,33 +145,29 @@ public:
      */
     void swap(GLuint eID, GLuint other)
     {
-        std::swap(mList[mIndex[eID]], mList[mIndex[other]]); // Swap the two entities in the pool
-        std::swap(mIndex[eID], mIndex[other]);               // Set the index to point to the location after swap
+        int &lhs{slot(eID)};
+        int &rhs{slot(other)};
+        std::swap(mList[lhs], mList[rhs]); // Swap the two entities in the pool
+        std::swap(lhs, rhs);               // Set the index to point to the location after swap
     }
     /**
      * Inserts an entity into the sparse set.
-     * Pads the index if entityID value is larger than size of mIndex.
+     * Allocates the page holding entityID if it doesn't exist yet.
+     * A stale handle to an older version of the entity is replaced, which can only happen when used as a pure sparse set,
+     * since pools drop an entity's components when it's destroyed.
      * @param entityID
      */
     void insert(GLuint entityID)
     {
-        if ((size_t)entityID > extent()) {
-            pad(entityID);
+        assure(page(entityID));
+        if (slot(entityID) != -1) {
+            mList[slot(entityID)] = entityID;
+            return;
         }
-        if (entityID < extent())
-            mIndex[entityID] = size();
-        else
-            mIndex.push_back(size()); // entity list size is location of new entityID
+        slot(entityID) = size(); // entity list size is location of new entityID
+        mPageCount[page(entityID)]++;
         mList.push_back(entityID);
     }
-    /**
-     * Returns a copy of the mIndex vector.
-     * @return
-     */
-    std::vector<int> getIndices() const
-    {
-        return mIndex;
-    }
     /**
      * Returns a copy of the mList vector.
      * @return
@@ -169,10 +194,38 @@ public:
     }
 
 private:
-    /// Sparse array -- index is the entityID. Value contained is the index location of each entityID in mEntityList
-    std::vector<int> mIndex;
+    /// Sparse array split into pages -- the entity index / PageSize selects the page, the remainder the slot in it.
+    /// Value contained is the index location of each entityID in mList.
+    std::vector<Page> mPages;
+    /// Number of live entities in each page, used to release a page once it's empty.
+    std::vector<GLuint> mPageCount;
     /// Contains the ID of each entity.
     std::vector<GLuint> mList;
+
+    static size_t page(GLuint entityID) { return Entity::index(entityID) / PageSize; }
+    static size_t offset(GLuint entityID) { return entityID & (PageSize - 1); }
+    /**
+     * Read-write reference to the sparse array slot of an entity. The page must be allocated.
+     * @param entityID
+     * @return
+     */
+    int &slot(GLuint entityID)
+    {
+        return mPages[page(entityID)][offset(entityID)];
+    }
+    /**
+     * Make sure the given page exists and is allocated.
+     * @param pos
+     */
+    void assure(size_t pos)
+    {
+        if (pos >= mPages.size()) {
+            mPages.resize(pos + 1);
+            mPageCount.resize(pos + 1, 0);
+        }
+        if (mPages[pos].empty())
+            mPages[pos].assign(PageSize, -1);
+    }
 };
 
 #endif // SPARSESET_H
@@ -0,0 +1,66 @@
+#include "spatialgrid.h"
+#include <algorithm>
+#include <cmath>
+
+void SpatialGrid::setCellSize(float size)
+{
+    mCellSize = std::max(size, 0.01f);
+    clear();
+}
+
+void SpatialGrid::clear()
+{
+    mEntries.clear();
+    mCells.clear();
+    mItemCount = 0;
+}
+
+void SpatialGrid::insert(GLuint item, const vec3 &min, const vec3 &max)
+{
+    const CellRange range{cells(min, max)};
+    for (std::int32_t x{range.minX}; x <= range.maxX; x++) {
+        for (std::int32_t z{range.minZ}; z <= range.maxZ; z++)
+            mEntries.push_back(Entry{key(x, z), item, min, max});
+    }
+    mItemCount = std::max(mItemCount, static_cast<size_t>(item) + 1);
+}
+
+void SpatialGrid::build()
+{
+    std::sort(mEntries.begin(), mEntries.end(), [](const Entry &lhs, const Entry &rhs) { return lhs.cell < rhs.cell; });
+    mCells.clear();
+    for (size_t first{0}; first < mEntries.size();) {
+        size_t last{first + 1};
+        while (last < mEntries.size() && mEntries[last].cell == mEntries[first].cell)
+            last++;
+        mCells[mEntries[first].cell] = {first, last};
+        first = last;
+    }
+    mItems.resize(mEntries.size());
+    for (int axis{0}; axis < 3; axis++) {
+        mMin[axis].resize(mEntries.size());
+        mMax[axis].resize(mEntries.size());
+    }
+    for (size_t i{0}; i < mEntries.size(); i++) {
+        mItems[i] = mEntries[i].item;
+        for (int axis{0}; axis < 3; axis++) {
+            mMin[axis][i] = mEntries[i].min[axis];
+            mMax[axis][i] = mEntries[i].max[axis];
+        }
+    }
+    if (mVisited.size() < mItemCount)
+        mVisited.resize(mItemCount, mQuery);
+}
+
+SpatialGrid::CellRange SpatialGrid::cells(const vec3 &min, const vec3 &max) const
+{
+    const float inverse{1.f / mCellSize};
+    return CellRange{static_cast<std::int32_t>(std::floor(min.x * inverse)), static_cast<std::int32_t>(std::floor(max.x * inverse)),
+                     static_cast<std::int32_t>(std::floor(min.z * inverse)), static_cast<std::int32_t>(std::floor(max.z * inverse))};
+}
+
+void SpatialGrid::restartQueries()
+{
+    std::fill(mVisited.begin(), mVisited.end(), 0);
+    mQuery = 1;
+}
@@ -0,0 +1,136 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include "gltypes.h"
+#include "vector3d.h"
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The SpatialGrid class is a uniform grid broadphase, splitting the ground plane (x and z) into square cells.
+ * Height is ignored, since the levels are flat and everything stands on the same plane.
+ * Items are boxes given by their world bounds, identified by an index into the caller's own list.
+ * The grid is meant to be rebuilt every tick: clear() it, insert() everything, build(), then query() it as often as needed.
+ * Only occupied cells take up memory, so the level can be any size.
+ * The boxes are also stored cell by cell, one array per coordinate, so queryCells() can hand whole cells to the gsl::simd kernels.
+ */
+class SpatialGrid {
+    using vec3 = gsl::Vector3D;
+
+public:
+    /**
+     * Length of a cell's sides. Should be around the size of the largest common query,
+     * too small makes big boxes cover many cells, too large puts too many items in each cell.
+     * Clears the grid.
+     * @param size
+     */
+    void setCellSize(float size);
+    float cellSize() const { return mCellSize; }
+    /**
+     * Remove every item.
+     */
+    void clear();
+    /**
+     * Add an item covering the box from min to max.
+     * @param item Index of the item in the caller's list.
+     * @param min
+     * @param max
+     */
+    void insert(GLuint item, const vec3 &min, const vec3 &max);
+    /**
+     * Sort the inserted items into their cells. Must be called after inserting and before querying.
+     */
+    void build();
+    /**
+     * Calls func(item) once for every item sharing a cell with the box from min to max.
+     * These are only candidates, the caller still has to check if they actually overlap.
+     * @param min
+     * @param max
+     * @param func
+     */
+    template <typename Func>
+    void query(const vec3 &min, const vec3 &max, Func func)
+    {
+        if (++mQuery == 0) // Wrapped around, forget the old queries
+            restartQueries();
+        const CellRange range{cells(min, max)};
+        for (std::int32_t x{range.minX}; x <= range.maxX; x++) {
+            for (std::int32_t z{range.minZ}; z <= range.maxZ; z++) {
+                auto cell{mCells.find(key(x, z))};
+                if (cell == mCells.end())
+                    continue;
+                for (size_t i{cell->second.first}; i < cell->second.second; i++) {
+                    const GLuint item{mItems[i]};
+                    // Items covering several cells the box also covers are only reported once
+                    if (mVisited[item] != mQuery) {
+                        mVisited[item] = mQuery;
+                        func(item);
+                    }
+                }
+            }
+        }
+    }
+    /**
+     * Calls func(items, min, max, count) for every occupied cell sharing space with the box from min to max,
+     * items being the count items in the cell, and min and max three arrays of their count boxes' corners.
+     * Unlike query(), an item covering several of the cells is passed once for each of them.
+     * @param min
+     * @param max
+     * @param func
+     */
+    template <typename Func>
+    void queryCells(const vec3 &min, const vec3 &max, Func func) const
+    {
+        const CellRange range{cells(min, max)};
+        for (std::int32_t x{range.minX}; x <= range.maxX; x++) {
+            for (std::int32_t z{range.minZ}; z <= range.maxZ; z++) {
+                auto cell{mCells.find(key(x, z))};
+                if (cell == mCells.end())
+                    continue;
+                const size_t first{cell->second.first};
+                const GLfloat *const cellMin[3]{mMin[0].data() + first, mMin[1].data() + first, mMin[2].data() + first};
+                const GLfloat *const cellMax[3]{mMax[0].data() + first, mMax[1].data() + first, mMax[2].data() + first};
+                func(mItems.data() + first, cellMin, cellMax, cell->second.second - first);
+            }
+        }
+    }
+    /**
+     * Number of item indices in use since the last clear(), the highest inserted index + 1.
+     * @return
+     */
+    size_t size() const { return mItemCount; }
+
+private:
+    struct Entry {
+        std::uint64_t cell;
+        GLuint item;
+        vec3 min;
+        vec3 max;
+    };
+    struct CellRange {
+        std::int32_t minX, maxX, minZ, maxZ;
+    };
+    float mCellSize{4.f};
+    /// One entry per cell an item covers, sorted by cell in build()
+    std::vector<Entry> mEntries;
+    /// First and one past the last entry of every occupied cell
+    std::unordered_map<std::uint64_t, std::pair<size_t, size_t>> mCells;
+    /// Query an item was last reported in, to skip duplicates
+    std::vector<std::uint32_t> mVisited;
+    std::uint32_t mQuery{0};
+    size_t mItemCount{0};
+    /// The entries' items and boxes, packed in the same order by build()
+    std::vector<GLuint> mItems;
+    std::array<std::vector<GLfloat>, 3> mMin, mMax;
+
+    CellRange cells(const vec3 &min, const vec3 &max) const;
+    void restartQueries();
+    static std::uint64_t key(std::int32_t x, std::int32_t z)
+    {
+        return static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32 | static_cast<std::uint32_t>(z);
+    }
+};
+
+#endif // SPATIALGRID_H
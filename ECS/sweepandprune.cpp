@@ -0,0 +1,76 @@
+#include "sweepandprune.h"
+#include <algorithm>
+
+void SweepAndPrune::setAxis(int axis)
+{
+    mAxis = std::clamp(axis, 0, 2);
+    // Every interval is along the old axis, start over from the boxes
+    mIntervals.clear();
+    mAdded = 0;
+    for (auto &box : mBoxes)
+        box.inSweep = false;
+}
+
+void SweepAndPrune::begin()
+{
+    if (++mFrame == 0) { // Wrapped around, an old stamp could look current
+        for (auto &box : mBoxes)
+            box.frame = 0;
+        mFrame = 1;
+    }
+}
+
+void SweepAndPrune::update(GLuint item, const vec3 &min, const vec3 &max)
+{
+    if (item >= mBoxes.size())
+        mBoxes.resize(item + 1);
+    Box &box{mBoxes[item]};
+    box.min = min;
+    box.max = max;
+    box.frame = mFrame;
+    if (!box.inSweep) {
+        box.inSweep = true;
+        mIntervals.push_back(interval(min, max, item));
+        mAdded++;
+    }
+}
+
+void SweepAndPrune::sort()
+{
+    // Refresh the intervals, dropping the items that weren't updated
+    const size_t sorted{mIntervals.size() - mAdded};
+    size_t kept{0}, keptSorted{0};
+    for (size_t i{0}; i < mIntervals.size(); i++) {
+        const GLuint item{mIntervals[i].item};
+        Box &box{mBoxes[item]};
+        if (box.frame != mFrame) {
+            box.inSweep = false;
+            continue;
+        }
+        mIntervals[kept++] = interval(box.min, box.max, item);
+        if (i < sorted)
+            keptSorted++;
+    }
+    mIntervals.resize(kept);
+    mAdded = 0;
+
+    // Insertion sort on the old items, which only moved a little since the last frame
+    const auto begin{mIntervals.begin()}, middle{begin + static_cast<std::ptrdiff_t>(keptSorted)};
+    for (auto itr{begin}; itr < middle; ++itr) {
+        const Interval moved{*itr};
+        auto hole{itr};
+        for (; hole != begin && (hole - 1)->min > moved.min; --hole)
+            *hole = *(hole - 1);
+        *hole = moved;
+    }
+    // The new ones can be anywhere, so they get sorted on their own and merged in
+    const auto byMin = [](const Interval &lhs, const Interval &rhs) { return lhs.min < rhs.min; };
+    std::sort(middle, mIntervals.end(), byMin);
+    std::inplace_merge(begin, middle, mIntervals.end(), byMin);
+}
+
+SweepAndPrune::Interval SweepAndPrune::interval(const vec3 &min, const vec3 &max, GLuint item) const
+{
+    const int first{(mAxis + 1) % 3}, second{(mAxis + 2) % 3};
+    return Interval{min[mAxis], max[mAxis], min[first], max[first], min[second], max[second], item};
+}
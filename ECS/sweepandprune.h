@@ -0,0 +1,89 @@
+#ifndef SWEEPANDPRUNE_H
+#define SWEEPANDPRUNE_H
+
+#include "gltypes.h"
+#include "vector3d.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * The SweepAndPrune class is a broadphase finding every pair of overlapping boxes.
+ * The boxes are kept sorted by where they start along one axis, so only boxes close together on that axis are compared.
+ * The order is kept between frames, and since things don't move far in one frame it's nearly sorted already,
+ * which insertion sort handles in close to linear time.
+ * Items are identified by an index that must stay the same between frames, like an entity's index.
+ * Every frame: begin(), update() every item, then forEachPair(). Items that weren't updated since begin() are removed.
+ */
+class SweepAndPrune {
+    using vec3 = gsl::Vector3D;
+
+public:
+    /**
+     * Axis the boxes are sorted along, 0 to 2 for x, y and z. Should be the one the items are the most spread out along.
+     * @param axis
+     */
+    void setAxis(int axis);
+    int axis() const { return mAxis; }
+    /**
+     * Start a new frame.
+     */
+    void begin();
+    /**
+     * Set the box of an item, adding it if it's new.
+     * @param item
+     * @param min
+     * @param max
+     */
+    void update(GLuint item, const vec3 &min, const vec3 &max);
+    /**
+     * Sorts the boxes, then calls func(item, otherItem) once for every pair of overlapping boxes, as they're found.
+     * @param func
+     */
+    template <typename Func>
+    void forEachPair(Func func)
+    {
+        sort();
+        for (size_t i{0}; i < mIntervals.size(); i++) {
+            const Interval &box{mIntervals[i]};
+            // Every box starting before this one ends overlaps it along the axis, the first one starting after it ends the sweep
+            for (size_t j{i + 1}; j < mIntervals.size() && mIntervals[j].min <= box.max; j++) {
+                const Interval &other{mIntervals[j]};
+                if (box.min1 <= other.max1 && other.min1 <= box.max1 && box.min2 <= other.max2 && other.min2 <= box.max2)
+                    func(box.item, other.item);
+            }
+        }
+    }
+    size_t size() const { return mIntervals.size(); }
+
+private:
+    struct Box {
+        vec3 min;
+        vec3 max;
+        /// Frame the box was last updated in
+        std::uint32_t frame{0};
+        bool inSweep{false};
+    };
+    /// Copy of a box in the sorted list, so the sweep reads through memory in order instead of looking up every box.
+    /// min and max are along the sorting axis, 1 and 2 the axes after it.
+    struct Interval {
+        float min, max;
+        float min1, max1;
+        float min2, max2;
+        GLuint item;
+    };
+    int mAxis{0};
+    std::uint32_t mFrame{0};
+    /// Indexed by item
+    std::vector<Box> mBoxes;
+    /// Sorted by min, except for the items added since the last sort at the end
+    std::vector<Interval> mIntervals;
+    size_t mAdded{0};
+
+    /**
+     * Drop the items that weren't updated this frame, and sort the rest by where they start.
+     */
+    void sort();
+    Interval interval(const vec3 &min, const vec3 &max, GLuint item) const;
+};
+
+#endif // SWEEPANDPRUNE_H
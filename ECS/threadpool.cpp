@@ -0,0 +1,118 @@
+#include "threadpool.h"
+
+ThreadPool *ThreadPool::mInstance = nullptr;
+
+namespace {
+/// Queue index of the pool worker running on this thread, -1 for threads outside the pool.
+thread_local int workerIndex{-1};
+} // namespace
+
+ThreadPool::ThreadPool(size_t threads)
+{
+    for (size_t i{0}; i <= threads; i++)
+        mQueues.push_back(std::make_unique<Queue>());
+    for (size_t i{0}; i < threads; i++)
+        mWorkers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool *ThreadPool::instance()
+{
+    if (!mInstance) {
+        // Leave one core for the GUI thread, which also helps out while it waits.
+        const unsigned cores{std::thread::hardware_concurrency()};
+        mInstance = new ThreadPool(cores > 1 ? cores - 1 : 0);
+    }
+    return mInstance;
+}
+
+void ThreadPool::setThreadCount(size_t threads)
+{
+    delete mInstance;
+    mInstance = new ThreadPool(threads > 1 ? threads - 1 : 0);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{mSleepMutex};
+        mStop = true;
+    }
+    mSleep.notify_all();
+    for (auto &worker : mWorkers)
+        worker.join();
+}
+
+void ThreadPool::push(size_t queue, Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock{mQueues[queue]->mutex};
+        mQueues[queue]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock{mSleepMutex};
+        mPending++;
+    }
+    mSleep.notify_one();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    push(localQueue(), std::move(task));
+}
+
+bool ThreadPool::help()
+{
+    return runOne(localQueue());
+}
+
+bool ThreadPool::runOne(size_t queue)
+{
+    Task task;
+    for (size_t i{0}; i < mQueues.size() && !task; i++) {
+        // Own queue first, taking the newest task. Then steal the oldest task from the others.
+        Queue &victim{*mQueues[(queue + i) % mQueues.size()]};
+        std::lock_guard<std::mutex> lock{victim.mutex};
+        if (victim.tasks.empty())
+            continue;
+        if (i == 0) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+        }
+        else {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+    if (!task)
+        return false;
+    mPending--;
+    task();
+    return true;
+}
+
+void ThreadPool::wait(const std::atomic<size_t> &remaining)
+{
+    const size_t queue{localQueue()};
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!runOne(queue))
+            std::this_thread::yield(); // Last chunks are running on other threads
+    }
+}
+
+void ThreadPool::workerLoop(size_t queue)
+{
+    workerIndex = static_cast<int>(queue);
+    while (true) {
+        if (runOne(queue))
+            continue;
+        std::unique_lock<std::mutex> lock{mSleepMutex};
+        mSleep.wait(lock, [this] { return mStop || mPending > 0; });
+        if (mStop)
+            return;
+    }
+}
+
+size_t ThreadPool::localQueue() const
+{
+    return workerIndex == -1 ? mQueues.size() - 1 : static_cast<size_t>(workerIndex);
+}
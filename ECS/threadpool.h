@@ -0,0 +1,121 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include "core.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * The ThreadPool class is a small work-stealing thread pool used for parallel iteration over Views and Groups.
+ * Every worker owns a task queue and pops from its back; when it runs dry it steals from the front of the others.
+ * A thread waiting for its tasks to finish (including the GUI thread) helps out instead of blocking,
+ * so nested parallelFor() calls can't deadlock.
+ */
+class ThreadPool {
+    using Task = std::function<void()>;
+    /**
+     * Task queue belonging to one thread.
+     */
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+public:
+    static ThreadPool *instance();
+    /**
+     * Replaces the pool with one running the given number of threads, the calling thread included.
+     * instance() sizes the pool to the machine on its own, this is for measuring how work scales with the thread count.
+     * Must not be called while any work is queued or running.
+     * @param threads
+     */
+    static void setThreadCount(size_t threads);
+    ~ThreadPool();
+
+    /**
+     * Number of threads taking part in parallelFor(), the calling thread included.
+     * @return
+     */
+    size_t size() const { return mWorkers.size() + 1; }
+    /**
+     * Splits [0, count) into chunks and calls func(first, last) for each of them, spread across the pool.
+     * Returns once every chunk has been processed.
+     * @param count Number of items.
+     * @param chunkSize Number of items per chunk. 0 lets the pool pick a size based on the number of threads.
+     * Any other value gives the same chunk boundaries no matter how many threads the machine has,
+     * so work that is reduced per chunk gives reproducible results.
+     * @param func Callable taking the (first, last) item range of one chunk.
+     */
+    template <typename Func>
+    void parallelFor(size_t count, size_t chunkSize, const Func &func)
+    {
+        if (count == 0)
+            return;
+        if (chunkSize == 0)
+            chunkSize = std::max<size_t>(MinChunkSize, (count + size() * 4 - 1) / (size() * 4));
+        const size_t chunks{(count + chunkSize - 1) / chunkSize};
+        if (chunks == 1 || mWorkers.empty()) {
+            for (size_t first{0}; first < count; first += chunkSize)
+                func(first, std::min(first + chunkSize, count));
+            return;
+        }
+        std::atomic<size_t> remaining{chunks};
+        for (size_t chunk{0}; chunk < chunks; chunk++) {
+            const size_t first{chunk * chunkSize};
+            const size_t last{std::min(first + chunkSize, count)};
+            push(chunk % mQueues.size(), [&func, &remaining, first, last] {
+                func(first, last);
+                remaining.fetch_sub(1, std::memory_order_release);
+            });
+        }
+        wait(remaining);
+    }
+    /**
+     * Queues a single task on the current thread's queue. Idle workers will steal it.
+     * @param task
+     */
+    void submit(std::function<void()> task);
+    /**
+     * Runs one queued task on the calling thread, if there is one.
+     * Lets a thread waiting on queued work help out instead of spinning.
+     * @return false if there was nothing to run.
+     */
+    bool help();
+
+private:
+    ThreadPool(size_t threads);
+    static ThreadPool *mInstance;
+    /// Chunks smaller than this cost more in scheduling than they gain from running in parallel.
+    static constexpr size_t MinChunkSize{64};
+
+    std::vector<std::thread> mWorkers;
+    /// One queue per worker, plus the last one shared by any thread outside the pool.
+    std::vector<cjk::Scope<Queue>> mQueues;
+    /// Number of queued tasks not yet picked up by a thread.
+    std::atomic<size_t> mPending{0};
+    std::atomic<bool> mStop{false};
+    std::mutex mSleepMutex;
+    std::condition_variable mSleep;
+
+    void push(size_t queue, Task task);
+    /**
+     * Runs one task, from the given queue if possible, otherwise stolen from another.
+     * @return false if there was nothing to run.
+     */
+    bool runOne(size_t queue);
+    void wait(const std::atomic<size_t> &remaining);
+    void workerLoop(size_t queue);
+    /**
+     * Index of the queue belonging to the current thread.
+     * @return
+     */
+    size_t localQueue() const;
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,231 @@
+#ifndef TRANSFORMSTREAMS_H
+#define TRANSFORMSTREAMS_H
+
+#include "entity.h"
+#include "gltypes.h"
+#include "matrix4x4.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * The TransformStreams class holds the hot, per frame parts of every Transform in their own contiguous arrays,
+ * so the Transform component itself only keeps the local position/rotation/scale and the hierarchy links.
+ * Those stay in the component because the editor, scripts and scene files edit them through get<Transform>() references,
+ * and MovementSystem only reads them for the Transforms flagged dirty, or for all of them when the hierarchy order is rebuilt.
+ * The dirty flags are a bitset, one bit per entity, which lets MovementSystem find the outdated Transforms
+ * by scanning 64 entities per word instead of pulling every component through the cache.
+ * The world (model) matrices are a separate array read by the RenderSystem and the colliders.
+ * Next to them is each entity's world Translation * Rotation matrix, which is what children and colliders inherit.
+ * The streams are indexed by the entity's index rather than its position in the Transform pool,
+ * since Groups reorder the pool, and so they work the same with either storage backend.
+ * Last is the hierarchy order, every entity with a Transform sorted so parents come before their children,
+ * which lets MovementSystem update the whole hierarchy in one pass.
+ * While playing, a copy of the world Translation * Rotation matrices is saved at the start of every fixed tick,
+ * so RenderSystem can blend between the last two ticks.
+ */
+class TransformStreams {
+    using Word = std::uint64_t;
+    static constexpr GLuint WordBits{64};
+
+public:
+    /**
+     * Flag an entity's world matrix as outdated, to be recalculated by MovementSystem on its next update.
+     * @param eID
+     */
+    void markDirty(GLuint eID)
+    {
+        const GLuint index{Entity::index(eID)};
+        assure(index);
+        mDirty[index / WordBits] |= Word{1} << (index % WordBits);
+    }
+    /**
+     * Flag many entities' world matrices as outdated at once.
+     * @param eIDs
+     */
+    void markDirty(const std::vector<GLuint> &eIDs)
+    {
+        GLuint last{0};
+        for (const GLuint eID : eIDs)
+            last = std::max(last, Entity::index(eID));
+        if (!eIDs.empty())
+            assure(last);
+        for (const GLuint eID : eIDs) {
+            const GLuint index{Entity::index(eID)};
+            mDirty[index / WordBits] |= Word{1} << (index % WordBits);
+        }
+    }
+    /**
+     * Check if an entity's world matrix is outdated.
+     * @param eID
+     * @return
+     */
+    bool isDirty(GLuint eID) const
+    {
+        const GLuint index{Entity::index(eID)};
+        return index / WordBits < mDirty.size() && (mDirty[index / WordBits] >> (index % WordBits) & 1);
+    }
+    void clearDirty(GLuint eID)
+    {
+        const GLuint index{Entity::index(eID)};
+        if (index / WordBits < mDirty.size())
+            mDirty[index / WordBits] &= ~(Word{1} << (index % WordBits));
+    }
+    /**
+     * Check if any entity is dirty, scanning only the bitset.
+     * @return
+     */
+    bool anyDirty() const
+    {
+        for (const Word word : mDirty) {
+            if (word)
+                return true;
+        }
+        return false;
+    }
+    /**
+     * World matrix of an entity, as of the last MovementSystem update.
+     * @param eID
+     * @return
+     */
+    gsl::Matrix4x4 &world(GLuint eID)
+    {
+        const GLuint index{Entity::index(eID)};
+        assure(index);
+        return mWorld[index];
+    }
+    /**
+     * @copydoc TransformStreams::world(GLuint)
+     * The entity must have been given a Transform, otherwise the index may be out of range.
+     */
+    const gsl::Matrix4x4 &world(GLuint eID) const { return mWorld[Entity::index(eID)]; }
+    /**
+     * World Translation * Rotation matrix of an entity, its world matrix without the scale.
+     * Children and colliders are placed relative to this, since they don't inherit their parent's scale.
+     * @param eID
+     * @return
+     */
+    gsl::Matrix4x4 &worldTR(GLuint eID)
+    {
+        const GLuint index{Entity::index(eID)};
+        assure(index);
+        return mWorldTR[index];
+    }
+    /**
+     * @copydoc TransformStreams::worldTR(GLuint)
+     * The entity must have been given a Transform, otherwise the index may be out of range.
+     */
+    const gsl::Matrix4x4 &worldTR(GLuint eID) const { return mWorldTR[Entity::index(eID)]; }
+    /**
+     * Flag a new Transform, which is both outdated and missing from the hierarchy order.
+     * @param eID
+     */
+    void add(GLuint eID)
+    {
+        markDirty(eID);
+        const GLuint index{Entity::index(eID)};
+        mAdded[index / WordBits] |= Word{1} << (index % WordBits);
+        mOrderOutdated = true;
+    }
+    /**
+     * Forget a removed Transform, so an entity reusing the index doesn't inherit its dirty flag, matrices or saved state to blend from.
+     * Its slot in the hierarchy order is left until the next sort, it's skipped since it's no longer dirty.
+     * @param eID
+     */
+    void remove(GLuint eID)
+    {
+        const GLuint index{Entity::index(eID)};
+        if (index >= mWorld.size())
+            return;
+        mDirty[index / WordBits] &= ~(Word{1} << (index % WordBits));
+        mAdded[index / WordBits] |= Word{1} << (index % WordBits);
+        mWorld[index] = gsl::Matrix4x4(true);
+        mWorldTR[index] = gsl::Matrix4x4(true);
+        if (index < mPreviousTR.size())
+            mPreviousTR[index] = gsl::Matrix4x4(true);
+    }
+    /**
+     * Copy every world Translation * Rotation matrix, as the state to blend from until the next copy.
+     */
+    void savePrevious()
+    {
+        mPreviousTR = mWorldTR;
+        std::fill(mAdded.begin(), mAdded.end(), Word{0});
+    }
+    /**
+     * Whether an entity has a saved matrix to blend from, which it doesn't if its Transform was added after the last savePrevious().
+     * @param eID
+     * @return
+     */
+    bool hasPrevious(GLuint eID) const
+    {
+        const GLuint index{Entity::index(eID)};
+        return index < mPreviousTR.size() && !(mAdded[index / WordBits] >> (index % WordBits) & 1);
+    }
+    /**
+     * World Translation * Rotation matrix of an entity as of the last savePrevious(). Check hasPrevious() first.
+     * @param eID
+     * @return
+     */
+    const gsl::Matrix4x4 &previousTR(GLuint eID) const { return mPreviousTR[Entity::index(eID)]; }
+    /**
+     * Flag the hierarchy order as outdated, after a parent/child link changed.
+     */
+    void invalidateOrder() { mOrderOutdated = true; }
+    bool orderOutdated() const { return mOrderOutdated; }
+    /**
+     * Entity indices sorted so every parent comes before its children.
+     * May hold indices of entities destroyed since it was last sorted.
+     * @return
+     */
+    const std::vector<GLuint> &order() const { return mOrder; }
+    void setOrder(std::vector<GLuint> order)
+    {
+        mOrder = std::move(order);
+        mOrderOutdated = false;
+    }
+    /**
+     * Forget every stream, used when the scene is cleared.
+     */
+    void clear()
+    {
+        mDirty.clear();
+        mWorld.clear();
+        mWorldTR.clear();
+        mPreviousTR.clear();
+        mAdded.clear();
+        mOrder.clear();
+        mOrderOutdated = true;
+    }
+    /**
+     * Bytes held by the streams.
+     * @return
+     */
+    size_t memoryUsage() const
+    {
+        return (mDirty.capacity() + mAdded.capacity()) * sizeof(Word) +
+               (mWorld.capacity() + mWorldTR.capacity() + mPreviousTR.capacity()) * sizeof(gsl::Matrix4x4) +
+               mOrder.capacity() * sizeof(GLuint);
+    }
+
+private:
+    std::vector<Word> mDirty;
+    std::vector<gsl::Matrix4x4> mWorld;
+    std::vector<gsl::Matrix4x4> mWorldTR;
+    std::vector<gsl::Matrix4x4> mPreviousTR;
+    std::vector<Word> mAdded; ///< Entities added since the last savePrevious()
+    std::vector<GLuint> mOrder;
+    bool mOrderOutdated{true};
+
+    void assure(GLuint index)
+    {
+        if (index >= mWorld.size()) {
+            mWorld.resize(index + 1, gsl::Matrix4x4(true));
+            mWorldTR.resize(index + 1, gsl::Matrix4x4(true));
+            mDirty.resize(index / WordBits + 1);
+            mAdded.resize(index / WordBits + 1);
+        }
+    }
+};
+
+#endif // TRANSFORMSTREAMS_H
@@ -1,6 +1,7 @@
 #ifndef VIEW_H
 #define VIEW_H
 #include "pool.h"
+#include "threadpool.h"
 #include <algorithm>
 /**
  * Multi-Component View.
@@ -170,6 +171,40 @@ public:
         else
             return std::tuple<decltype(get<Comp>(entt))...>{get<Comp>(entt)...};
     }
+    /**
+     * Calls func(entity, Component &...) for every entity in the View.
+     * @example view.each([](GLuint entity, Transform &trans, Mesh &mesh) { ... });
+     * @param func
+     */
+    template <typename Func>
+    void each(Func func) const
+    {
+        for (auto entity : *this)
+            func(entity, std::get<Pool<Component> *>(pools)->get(entity)...);
+    }
+    /**
+     * Parallel version of each(). The entities of the smallest pool are split into chunks that run on the ThreadPool.
+     * Components are handed out as writable references, declare a parameter as const Type & to mark it read-only.
+     * Rules for the callable, since calls for different entities run at the same time:
+     * - Write only to the components passed in for the current entity.
+     * - Reading another entity's components is fine as long as no par_each in flight writes that type.
+     * - Don't add/remove components or create/destroy entities, the pools may reallocate.
+     * @param func Callable taking (GLuint entity, Component &...).
+     * @param chunkSize Entities per chunk, 0 to let the pool decide. A fixed value gives the same chunks on every machine.
+     */
+    template <typename Func>
+    void par_each(Func func, size_t chunkSize = 0) const
+    {
+        const IPool *view{candidate()};
+        const unchecked_type other{unchecked(view)};
+        const GLuint *entity{view->entities()};
+        ThreadPool::instance()->parallelFor(view->size(), chunkSize, [&](size_t first, size_t last) {
+            for (size_t pos{first}; pos < last; pos++) {
+                if (std::all_of(other.cbegin(), other.cend(), [&](const IPool *pool) { return pool->has(entity[pos]); }))
+                    func(entity[pos], std::get<Pool<Component> *>(pools)->get(entity[pos])...);
+            }
+        });
+    }
 
 private:
     View(Pool<Component> *... ref)
@@ -284,6 +319,34 @@ public:
         assert(contains(entt));
         return pool->get(entt);
     }
+    /**
+     * Calls func(entity, Component &) for every entity in the View.
+     * Walks the pool's arrays directly, back to front like the iterator, so no lookup is needed per entity.
+     * @param func
+     */
+    template <typename Func>
+    void each(Func func) const
+    {
+        const GLuint *entity{pool->entities()};
+        Component *component{pool->raw()};
+        for (size_t pos{pool->size()}; pos > 0; pos--)
+            func(entity[pos - 1], component[pos - 1]);
+    }
+    /**
+     * Parallel version of each(), with the same rules as the multi-component View::par_each().
+     * @param func Callable taking (GLuint entity, Component &).
+     * @param chunkSize Entities per chunk, 0 to let the pool decide.
+     */
+    template <typename Func>
+    void par_each(Func func, size_t chunkSize = 0) const
+    {
+        const GLuint *entity{pool->entities()};
+        Component *component{pool->raw()};
+        ThreadPool::instance()->parallelFor(pool->size(), chunkSize, [&](size_t first, size_t last) {
+            for (size_t pos{first}; pos < last; pos++)
+                func(entity[pos], component[pos]);
+        });
+    }
 
 private:
     View(Pool<Component> *ref)
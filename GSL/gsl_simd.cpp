@@ -0,0 +1,462 @@
+#include "gsl_simd.h"
+#include "gsl_math.h"
+#include "matrix4x4.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(GSL_SIMD_AVX)
+#include <immintrin.h>
+#elif defined(GSL_SIMD_SSE)
+#include <emmintrin.h>
+#endif
+
+namespace gsl {
+namespace simd {
+
+namespace scalar {
+void multiply(const GLfloat *lhs, const GLfloat *rhs, GLfloat *out)
+{
+    GLfloat result[16];
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) {
+            result[row * 4 + col] = lhs[row * 4] * rhs[col] + lhs[row * 4 + 1] * rhs[4 + col] +
+                                    lhs[row * 4 + 2] * rhs[8 + col] + lhs[row * 4 + 3] * rhs[12 + col];
+        }
+    }
+    std::memcpy(out, result, sizeof(result));
+}
+
+void transform(const GLfloat *matrix, const GLfloat *vector, GLfloat *out)
+{
+    GLfloat result[4];
+    for (int row = 0; row < 4; row++) {
+        result[row] = matrix[row * 4] * vector[0] + matrix[row * 4 + 1] * vector[1] +
+                      matrix[row * 4 + 2] * vector[2] + matrix[row * 4 + 3] * vector[3];
+    }
+    std::memcpy(out, result, sizeof(result));
+}
+
+bool affineInverse(const GLfloat *matrix, GLfloat *out)
+{
+    // The columns of the inverted 3x3 part are the cross products of its rows, divided by the determinant.
+    const GLfloat *a0{matrix}, *a1{matrix + 4}, *a2{matrix + 8};
+    const GLfloat c0[3]{a1[1] * a2[2] - a1[2] * a2[1], a1[2] * a2[0] - a1[0] * a2[2], a1[0] * a2[1] - a1[1] * a2[0]};
+    const GLfloat c1[3]{a2[1] * a0[2] - a2[2] * a0[1], a2[2] * a0[0] - a2[0] * a0[2], a2[0] * a0[1] - a2[1] * a0[0]};
+    const GLfloat c2[3]{a0[1] * a1[2] - a0[2] * a1[1], a0[2] * a1[0] - a0[0] * a1[2], a0[0] * a1[1] - a0[1] * a1[0]};
+    const GLfloat det{a0[0] * c0[0] + a0[1] * c0[1] + a0[2] * c0[2]};
+    if (det == 0.f)
+        return false;
+    const GLfloat invDet{1.f / det};
+    const GLfloat translation[3]{matrix[3], matrix[7], matrix[11]};
+
+    GLfloat result[16];
+    for (int row = 0; row < 3; row++) {
+        result[row * 4] = c0[row] * invDet;
+        result[row * 4 + 1] = c1[row] * invDet;
+        result[row * 4 + 2] = c2[row] * invDet;
+        result[row * 4 + 3] = -(result[row * 4] * translation[0] + result[row * 4 + 1] * translation[1] + result[row * 4 + 2] * translation[2]);
+    }
+    result[12] = result[13] = result[14] = 0.f;
+    result[15] = 1.f;
+    std::memcpy(out, result, sizeof(result));
+    return true;
+}
+} // namespace scalar
+
+#if defined(GSL_SIMD_SSE)
+namespace {
+/// a.yzx * b.zxy - a.zxy * b.yzx, the w lane ends up as 0.
+inline __m128 cross(__m128 a, __m128 b)
+{
+    const __m128 aYZX{_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1))};
+    const __m128 bYZX{_mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1))};
+    const __m128 aZXY{_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2))};
+    const __m128 bZXY{_mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2))};
+    return _mm_sub_ps(_mm_mul_ps(aYZX, bZXY), _mm_mul_ps(aZXY, bYZX));
+}
+/// Dot product of every row with vector, summed in the same order as the scalar code so the results match exactly.
+inline __m128 transformRows(__m128 row0, __m128 row1, __m128 row2, __m128 row3, __m128 vector)
+{
+    row0 = _mm_mul_ps(row0, vector);
+    row1 = _mm_mul_ps(row1, vector);
+    row2 = _mm_mul_ps(row2, vector);
+    row3 = _mm_mul_ps(row3, vector);
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+    return _mm_add_ps(_mm_add_ps(_mm_add_ps(row0, row1), row2), row3);
+}
+} // namespace
+
+void transform(const GLfloat *matrix, const GLfloat *vector, GLfloat *out)
+{
+    _mm_storeu_ps(out, transformRows(_mm_loadu_ps(matrix), _mm_loadu_ps(matrix + 4), _mm_loadu_ps(matrix + 8),
+                                     _mm_loadu_ps(matrix + 12), _mm_loadu_ps(vector)));
+}
+
+bool affineInverse(const GLfloat *matrix, GLfloat *out)
+{
+    const __m128 a0{_mm_loadu_ps(matrix)};
+    const __m128 a1{_mm_loadu_ps(matrix + 4)};
+    const __m128 a2{_mm_loadu_ps(matrix + 8)};
+    __m128 c0{cross(a1, a2)};
+    __m128 c1{cross(a2, a0)};
+    __m128 c2{cross(a0, a1)};
+    GLfloat products[4];
+    _mm_storeu_ps(products, _mm_mul_ps(a0, c0));
+    const GLfloat det{products[0] + products[1] + products[2]};
+    if (det == 0.f)
+        return false;
+
+    // Rows of the inverted 3x3 part are the transposed cross products
+    const __m128 invDet{_mm_set1_ps(1.f / det)};
+    __m128 c3{_mm_setzero_ps()};
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    c0 = _mm_mul_ps(c0, invDet);
+    c1 = _mm_mul_ps(c1, invDet);
+    c2 = _mm_mul_ps(c2, invDet);
+    const __m128 translation{_mm_setr_ps(matrix[3], matrix[7], matrix[11], 0.f)};
+    GLfloat moved[4];
+    _mm_storeu_ps(moved, transformRows(c0, c1, c2, _mm_setzero_ps(), translation));
+
+    _mm_storeu_ps(out, c0);
+    _mm_storeu_ps(out + 4, c1);
+    _mm_storeu_ps(out + 8, c2);
+    _mm_storeu_ps(out + 12, _mm_setr_ps(0.f, 0.f, 0.f, 1.f));
+    out[3] = -moved[0];
+    out[7] = -moved[1];
+    out[11] = -moved[2];
+    return true;
+}
+#endif
+
+#if defined(GSL_SIMD_AVX)
+void multiply(const GLfloat *lhs, const GLfloat *rhs, GLfloat *out)
+{
+    // Two rows at a time, one per 128 bit lane, with every row of rhs repeated in both lanes
+    const __m256 b0{_mm256_broadcast_ps(reinterpret_cast<const __m128 *>(rhs))};
+    const __m256 b1{_mm256_broadcast_ps(reinterpret_cast<const __m128 *>(rhs + 4))};
+    const __m256 b2{_mm256_broadcast_ps(reinterpret_cast<const __m128 *>(rhs + 8))};
+    const __m256 b3{_mm256_broadcast_ps(reinterpret_cast<const __m128 *>(rhs + 12))};
+    auto rows = [&](__m256 a) {
+        __m256 result{_mm256_mul_ps(_mm256_permute_ps(a, 0x00), b0)};
+        result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_permute_ps(a, 0x55), b1));
+        result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_permute_ps(a, 0xAA), b2));
+        return _mm256_add_ps(result, _mm256_mul_ps(_mm256_permute_ps(a, 0xFF), b3));
+    };
+    const __m256 rows01{rows(_mm256_loadu_ps(lhs))};
+    const __m256 rows23{rows(_mm256_loadu_ps(lhs + 8))};
+    _mm256_storeu_ps(out, rows01);
+    _mm256_storeu_ps(out + 8, rows23);
+}
+#elif defined(GSL_SIMD_SSE)
+void multiply(const GLfloat *lhs, const GLfloat *rhs, GLfloat *out)
+{
+    const __m128 b0{_mm_loadu_ps(rhs)};
+    const __m128 b1{_mm_loadu_ps(rhs + 4)};
+    const __m128 b2{_mm_loadu_ps(rhs + 8)};
+    const __m128 b3{_mm_loadu_ps(rhs + 12)};
+    __m128 rows[4];
+    for (int row = 0; row < 4; row++) {
+        const GLfloat *a{lhs + row * 4};
+        rows[row] = _mm_mul_ps(_mm_set1_ps(a[0]), b0);
+        rows[row] = _mm_add_ps(rows[row], _mm_mul_ps(_mm_set1_ps(a[1]), b1));
+        rows[row] = _mm_add_ps(rows[row], _mm_mul_ps(_mm_set1_ps(a[2]), b2));
+        rows[row] = _mm_add_ps(rows[row], _mm_mul_ps(_mm_set1_ps(a[3]), b3));
+    }
+    for (int row = 0; row < 4; row++)
+        _mm_storeu_ps(out + row * 4, rows[row]);
+}
+#else
+void multiply(const GLfloat *lhs, const GLfloat *rhs, GLfloat *out)
+{
+    scalar::multiply(lhs, rhs, out);
+}
+void transform(const GLfloat *matrix, const GLfloat *vector, GLfloat *out)
+{
+    scalar::transform(matrix, vector, out);
+}
+bool affineInverse(const GLfloat *matrix, GLfloat *out)
+{
+    return scalar::affineInverse(matrix, out);
+}
+#endif
+
+void composeTRS(const GLfloat *translation, const GLfloat *rotation, const GLfloat *scale, GLfloat *out)
+{
+    // Closed form of RotationX * RotationY * RotationZ, with each column multiplied by its scale. The sines and cosines dominate here.
+    const GLfloat x{deg2radf(rotation[0])}, y{deg2radf(rotation[1])}, z{deg2radf(rotation[2])};
+    const GLfloat sx{std::sin(x)}, cx{std::cos(x)};
+    const GLfloat sy{std::sin(y)}, cy{std::cos(y)};
+    const GLfloat sz{std::sin(z)}, cz{std::cos(z)};
+
+    out[0] = cy * cz * scale[0];
+    out[1] = -cy * sz * scale[1];
+    out[2] = sy * scale[2];
+    out[3] = translation[0];
+
+    out[4] = (sx * sy * cz + cx * sz) * scale[0];
+    out[5] = (cx * cz - sx * sy * sz) * scale[1];
+    out[6] = -sx * cy * scale[2];
+    out[7] = translation[1];
+
+    out[8] = (sx * sz - cx * sy * cz) * scale[0];
+    out[9] = (cx * sy * sz + sx * cz) * scale[1];
+    out[10] = cx * cy * scale[2];
+    out[11] = translation[2];
+
+    out[12] = out[13] = out[14] = 0.f;
+    out[15] = 1.f;
+}
+
+namespace {
+/**
+ * Closed form Translation * Rotation and Translation * Rotation * Scale of one entity, rotation given as a unit quaternion.
+ * T is a float for the scalar version, or a register holding one entity per lane.
+ * The results are written to e[row * 4 + col], the rotation part of eTRS is eTR scaled by column.
+ */
+template <typename T>
+inline void composeElements(const T (&t)[3], const T (&q)[4], const T (&s)[3], T one, T zero, T (&eTR)[16], T (&eTRS)[16])
+{
+    const T x{q[0]}, y{q[1]}, z{q[2]}, w{q[3]};
+    const T two{one + one};
+    const T xx{x * x}, yy{y * y}, zz{z * z};
+    const T xy{x * y}, xz{x * z}, yz{y * z};
+    const T wx{w * x}, wy{w * y}, wz{w * z};
+    const T rotation[9]{
+        one - two * (yy + zz), two * (xy - wz), two * (xz + wy),
+        two * (xy + wz), one - two * (xx + zz), two * (yz - wx),
+        two * (xz - wy), two * (yz + wx), one - two * (xx + yy)};
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            eTR[row * 4 + col] = rotation[row * 3 + col];
+            eTRS[row * 4 + col] = rotation[row * 3 + col] * s[col];
+        }
+        eTR[row * 4 + 3] = eTRS[row * 4 + 3] = t[row];
+    }
+    eTR[12] = eTR[13] = eTR[14] = eTRS[12] = eTRS[13] = eTRS[14] = zero;
+    eTR[15] = eTRS[15] = one;
+}
+
+#if defined(GSL_SIMD_SSE)
+/// Thin wrappers giving SSE and AVX registers the arithmetic operators composeElements() needs
+struct Lanes4 {
+    static constexpr size_t Width{4};
+    __m128 v;
+};
+inline Lanes4 operator+(Lanes4 a, Lanes4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline Lanes4 operator-(Lanes4 a, Lanes4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline Lanes4 operator*(Lanes4 a, Lanes4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline void load(const GLfloat *values, Lanes4 &out) { out.v = _mm_loadu_ps(values); }
+inline void broadcast(GLfloat value, Lanes4 &out) { out.v = _mm_set1_ps(value); }
+inline void store(Lanes4 values, GLfloat *out) { _mm_storeu_ps(out, values.v); }
+inline Lanes4 minimum(Lanes4 a, Lanes4 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline Lanes4 maximum(Lanes4 a, Lanes4 b) { return {_mm_max_ps(a.v, b.v)}; }
+/// Lanes where a >= b are all ones, the rest zero
+inline Lanes4 greaterEqual(Lanes4 a, Lanes4 b) { return {_mm_cmpge_ps(a.v, b.v)}; }
+inline Lanes4 select(Lanes4 mask, Lanes4 a, Lanes4 b) { return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))}; }
+/// Writes element e[row * 4 + col] of 4 matrices, one per lane
+inline void store(const Lanes4 (&e)[16], Matrix4x4 *out)
+{
+    for (int row = 0; row < 4; row++) {
+        __m128 a{e[row * 4].v}, b{e[row * 4 + 1].v}, c{e[row * 4 + 2].v}, d{e[row * 4 + 3].v};
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+        _mm_storeu_ps(out[0].constData() + row * 4, a);
+        _mm_storeu_ps(out[1].constData() + row * 4, b);
+        _mm_storeu_ps(out[2].constData() + row * 4, c);
+        _mm_storeu_ps(out[3].constData() + row * 4, d);
+    }
+}
+#if defined(GSL_SIMD_AVX)
+struct Lanes8 {
+    static constexpr size_t Width{8};
+    __m256 v;
+};
+inline Lanes8 operator+(Lanes8 a, Lanes8 b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline Lanes8 operator-(Lanes8 a, Lanes8 b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline Lanes8 operator*(Lanes8 a, Lanes8 b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline void load(const GLfloat *values, Lanes8 &out) { out.v = _mm256_loadu_ps(values); }
+inline void broadcast(GLfloat value, Lanes8 &out) { out.v = _mm256_set1_ps(value); }
+inline void store(Lanes8 values, GLfloat *out) { _mm256_storeu_ps(out, values.v); }
+inline Lanes8 minimum(Lanes8 a, Lanes8 b) { return {_mm256_min_ps(a.v, b.v)}; }
+inline Lanes8 maximum(Lanes8 a, Lanes8 b) { return {_mm256_max_ps(a.v, b.v)}; }
+inline Lanes8 greaterEqual(Lanes8 a, Lanes8 b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)}; }
+inline Lanes8 select(Lanes8 mask, Lanes8 a, Lanes8 b) { return {_mm256_blendv_ps(b.v, a.v, mask.v)}; }
+/// Writes 8 matrices, as two sets of 4
+inline void store(const Lanes8 (&e)[16], Matrix4x4 *out)
+{
+    Lanes4 low[16], high[16];
+    for (int i = 0; i < 16; i++) {
+        low[i].v = _mm256_castps256_ps128(e[i].v);
+        high[i].v = _mm256_extractf128_ps(e[i].v, 1);
+    }
+    store(low, out);
+    store(high, out + 4);
+}
+#endif
+
+/**
+ * Composes the matrices of the entities starting at first, one per lane.
+ */
+template <typename Lanes>
+void composeBlock(size_t first, const GLfloat *const translation[3], const GLfloat *const orientation[4], const GLfloat *const scale[3],
+                  Matrix4x4 *outTR, Matrix4x4 *outTRS)
+{
+    Lanes t[3], q[4], s[3], one, zero;
+    for (int i = 0; i < 3; i++) {
+        load(translation[i] + first, t[i]);
+        load(scale[i] + first, s[i]);
+    }
+    for (int i = 0; i < 4; i++)
+        load(orientation[i] + first, q[i]);
+    broadcast(1.f, one);
+    broadcast(0.f, zero);
+    Lanes eTR[16], eTRS[16];
+    composeElements(t, q, s, one, zero, eTR, eTRS);
+    store(eTR, outTR + first);
+    store(eTRS, outTRS + first);
+}
+#endif
+} // namespace
+
+void composeTRS(size_t count, const GLfloat *const translation[3], const GLfloat *const orientation[4], const GLfloat *const scale[3],
+                Matrix4x4 *outTR, Matrix4x4 *outTRS)
+{
+    size_t first{0};
+#if defined(GSL_SIMD_AVX)
+    for (; first + Lanes8::Width <= count; first += Lanes8::Width)
+        composeBlock<Lanes8>(first, translation, orientation, scale, outTR, outTRS);
+#endif
+#if defined(GSL_SIMD_SSE)
+    for (; first + Lanes4::Width <= count; first += Lanes4::Width)
+        composeBlock<Lanes4>(first, translation, orientation, scale, outTR, outTRS);
+#endif
+    // The remaining entities, or all of them without SIMD
+    for (; first < count; first++) {
+        const GLfloat t[3]{translation[0][first], translation[1][first], translation[2][first]};
+        const GLfloat q[4]{orientation[0][first], orientation[1][first], orientation[2][first], orientation[3][first]};
+        const GLfloat s[3]{scale[0][first], scale[1][first], scale[2][first]};
+        GLfloat eTR[16], eTRS[16];
+        composeElements(t, q, s, 1.f, 0.f, eTR, eTRS);
+        std::memcpy(outTR[first].constData(), eTR, sizeof(eTR));
+        std::memcpy(outTRS[first].constData(), eTRS, sizeof(eTRS));
+    }
+}
+
+namespace {
+/// Scalar versions of the lane operations, behaving like the SSE instructions when a value is NaN
+inline GLfloat minimum(GLfloat a, GLfloat b) { return a < b ? a : b; }
+inline GLfloat maximum(GLfloat a, GLfloat b) { return a > b ? a : b; }
+inline bool greaterEqual(GLfloat a, GLfloat b) { return a >= b; }
+inline GLfloat select(bool mask, GLfloat a, GLfloat b) { return mask ? a : b; }
+inline void load(const GLfloat *values, GLfloat &out) { out = *values; }
+inline void broadcast(GLfloat value, GLfloat &out) { out = value; }
+inline void store(GLfloat value, GLfloat *out) { *out = value; }
+
+/**
+ * Ray against the boxes starting at first, one per lane. T is a float or a register.
+ */
+template <typename T>
+inline void rayBoxBlock(size_t first, const GLfloat *const min[3], const GLfloat *const max[3], const GLfloat *origin, const GLfloat *invDir,
+                        GLfloat *out)
+{
+    T tmin, tmax;
+    broadcast(0.f, tmin); // Boxes behind the ray are misses
+    broadcast(std::numeric_limits<GLfloat>::infinity(), tmax);
+    const T infinity{tmax};
+    for (int axis = 0; axis < 3; axis++) {
+        T boxMin, boxMax, o, inv;
+        load(min[axis] + first, boxMin);
+        load(max[axis] + first, boxMax);
+        broadcast(origin[axis], o);
+        broadcast(invDir[axis], inv);
+        const T t1{(boxMin - o) * inv};
+        const T t2{(boxMax - o) * inv};
+        tmin = maximum(tmin, minimum(t1, t2));
+        tmax = minimum(tmax, maximum(t1, t2));
+    }
+    store(select(greaterEqual(tmax, tmin), tmax, infinity), out + first);
+}
+
+/**
+ * Distance from a point to the boxes starting at first, one per lane. T is a float or a register.
+ */
+template <typename T>
+inline void boxDistanceSqBlock(size_t first, const GLfloat *const min[3], const GLfloat *const max[3], const GLfloat *point, GLfloat *out)
+{
+    T distanceSq, zero;
+    broadcast(0.f, zero);
+    distanceSq = zero;
+    for (int axis = 0; axis < 3; axis++) {
+        T boxMin, boxMax, p;
+        load(min[axis] + first, boxMin);
+        load(max[axis] + first, boxMax);
+        broadcast(point[axis], p);
+        // How far outside the box the point is along the axis, at most one of the two is positive
+        const T outside{maximum(maximum(boxMin - p, p - boxMax), zero)};
+        distanceSq = distanceSq + outside * outside;
+    }
+    store(distanceSq, out + first);
+}
+} // namespace
+
+void rayBoxes(size_t count, const GLfloat *const min[3], const GLfloat *const max[3], const GLfloat *origin, const GLfloat *invDir, GLfloat *out)
+{
+    size_t first{0};
+#if defined(GSL_SIMD_AVX)
+    for (; first + Lanes8::Width <= count; first += Lanes8::Width)
+        rayBoxBlock<Lanes8>(first, min, max, origin, invDir, out);
+#endif
+#if defined(GSL_SIMD_SSE)
+    for (; first + Lanes4::Width <= count; first += Lanes4::Width)
+        rayBoxBlock<Lanes4>(first, min, max, origin, invDir, out);
+#endif
+    for (; first < count; first++)
+        rayBoxBlock<GLfloat>(first, min, max, origin, invDir, out);
+}
+
+void boxDistancesSq(size_t count, const GLfloat *const min[3], const GLfloat *const max[3], const GLfloat *point, GLfloat *out)
+{
+    size_t first{0};
+#if defined(GSL_SIMD_AVX)
+    for (; first + Lanes8::Width <= count; first += Lanes8::Width)
+        boxDistanceSqBlock<Lanes8>(first, min, max, point, out);
+#endif
+#if defined(GSL_SIMD_SSE)
+    for (; first + Lanes4::Width <= count; first += Lanes4::Width)
+        boxDistanceSqBlock<Lanes4>(first, min, max, point, out);
+#endif
+    for (; first < count; first++)
+        boxDistanceSqBlock<GLfloat>(first, min, max, point, out);
+}
+
+void addScaled(size_t count, const GLfloat *values, GLfloat scale, GLfloat *out)
+{
+    size_t i{0};
+#if defined(GSL_SIMD_AVX)
+    const __m256 scale8{_mm256_set1_ps(scale)};
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(_mm256_loadu_ps(values + i), scale8)));
+#endif
+#if defined(GSL_SIMD_SSE)
+    const __m128 scale4{_mm_set1_ps(scale)};
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(values + i), scale4)));
+#endif
+    for (; i < count; i++)
+        out[i] += values[i] * scale;
+}
+
+const char *kernelName()
+{
+#if defined(GSL_SIMD_AVX)
+    return "AVX";
+#elif defined(GSL_SIMD_SSE)
+    return "SSE";
+#else
+    return "Scalar";
+#endif
+}
+
+} // namespace simd
+} // namespace gsl
@@ -0,0 +1,104 @@
+#ifndef GSL_SIMD_H
+#define GSL_SIMD_H
+
+#include "gltypes.h"
+
+#include <cstddef>
+
+// Pick the widest instruction set the compiler is allowed to use. GSL_SIMD_SSE means SSE2.
+// MSVC doesn't define __SSE2__, but every x64 target has it.
+#if defined(__AVX__)
+#define GSL_SIMD_AVX
+#define GSL_SIMD_SSE
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GSL_SIMD_SSE
+#endif
+
+namespace gsl {
+class Matrix4x4;
+/**
+ * Kernels for the hot Matrix4x4 operations, working on the row-major GLfloat[16] arrays Matrix4x4 stores.
+ * The functions in gsl::simd forward to the fastest version the build allows, chosen at compile time (AVX, SSE or scalar).
+ * The scalar versions are always compiled, and are what the others are checked against.
+ * None of the kernels require aligned arrays, and out may be the same array as an input.
+ */
+namespace simd {
+/**
+ * out = lhs * rhs
+ */
+void multiply(const GLfloat *lhs, const GLfloat *rhs, GLfloat *out);
+/**
+ * out = matrix * vector, vector being 4 floats.
+ */
+void transform(const GLfloat *matrix, const GLfloat *vector, GLfloat *out);
+/**
+ * Inverse of an affine matrix (bottom row 0, 0, 0, 1), which is a 3x3 inverse and a translation,
+ * much cheaper than the general inverse.
+ * @return false if the matrix can't be inverted, out is left untouched.
+ */
+bool affineInverse(const GLfloat *matrix, GLfloat *out);
+/**
+ * out = Translation * RotationX * RotationY * RotationZ * Scale, built directly instead of multiplying five matrices.
+ * Same result as calling translate(), rotateX(), rotateY(), rotateZ() and scale() on an identity matrix.
+ * @param translation x, y, z
+ * @param rotation Euler angles in degrees
+ * @param scale x, y, z
+ */
+void composeTRS(const GLfloat *translation, const GLfloat *rotation, const GLfloat *scale, GLfloat *out);
+/**
+ * Batch version of composeTRS() for many entities, reading their values from separate arrays (x, y, z and w of each)
+ * and composing 4 (SSE) or 8 (AVX) matrices at a time.
+ * The rotation is given as a unit quaternion, which turns into a matrix with a few multiplications and no sines or cosines.
+ * Writes both Translation * Rotation and Translation * Rotation * Scale, since children and colliders only inherit the former.
+ * @param count number of entities
+ * @param translation three arrays of count values
+ * @param orientation four arrays of count values, the x, y, z and w of each quaternion
+ * @param scale three arrays of count values
+ * @param outTR count matrices
+ * @param outTRS count matrices
+ */
+void composeTRS(size_t count, const GLfloat *const translation[3], const GLfloat *const orientation[4], const GLfloat *const scale[3],
+                Matrix4x4 *outTR, Matrix4x4 *outTRS);
+/**
+ * out[i] += values[i] * scale for count floats, e.g. every position of a batch moved by its velocity times the delta time.
+ * @param count
+ * @param values
+ * @param scale
+ * @param out
+ */
+void addScaled(size_t count, const GLfloat *values, GLfloat scale, GLfloat *out);
+/**
+ * Slab test of one ray against count boxes, given as one array per coordinate of their min and max corners.
+ * out[i] is the distance where the ray leaves box i, in units of the ray's direction,
+ * or infinity if the ray misses the box or the box is behind the ray.
+ * @param count
+ * @param min three arrays of count values
+ * @param max three arrays of count values
+ * @param origin x, y, z
+ * @param invDir 1 / the ray's direction, x, y, z
+ * @param out count distances
+ */
+void rayBoxes(size_t count, const GLfloat *const min[3], const GLfloat *const max[3], const GLfloat *origin, const GLfloat *invDir, GLfloat *out);
+/**
+ * Squared distance from a point, e.g. the centre of a sphere, to each of count boxes, 0 for the boxes containing it.
+ * @param count
+ * @param min three arrays of count values
+ * @param max three arrays of count values
+ * @param point x, y, z
+ * @param out count squared distances
+ */
+void boxDistancesSq(size_t count, const GLfloat *const min[3], const GLfloat *const max[3], const GLfloat *point, GLfloat *out);
+/**
+ * Name of the instruction set the kernels were compiled for.
+ */
+const char *kernelName();
+
+namespace scalar {
+void multiply(const GLfloat *lhs, const GLfloat *rhs, GLfloat *out);
+void transform(const GLfloat *matrix, const GLfloat *vector, GLfloat *out);
+bool affineInverse(const GLfloat *matrix, GLfloat *out);
+} // namespace scalar
+} // namespace simd
+} // namespace gsl
+
+#endif // GSL_SIMD_H
@@ -1,6 +1,7 @@
 #include "matrix4x4.h"
-//#include "quaternion.h"
+#include "quaternion.h"
 #include "gsl_math.h"
+#include "gsl_simd.h"
 #include "math_constants.h"
 #include "matrix2x2.h"
 #include "matrix3x3.h"
@@ -184,6 +185,35 @@ bool Matrix4x4::inverse()
     return true;
 }
 
+bool Matrix4x4::affineInverse()
+{
+    return simd::affineInverse(matrix, matrix);
+}
+
+Matrix4x4 Matrix4x4::composeTRS(const Vector3D &translation, const Vector3D &rotation, const Vector3D &scale)
+{
+    const GLfloat t[3]{translation.x, translation.y, translation.z};
+    const GLfloat r[3]{rotation.x, rotation.y, rotation.z};
+    const GLfloat s[3]{scale.x, scale.y, scale.z};
+    Matrix4x4 result;
+    simd::composeTRS(t, r, s, result.matrix);
+    return result;
+}
+
+Matrix4x4 Matrix4x4::composeTRS(const Vector3D &translation, const Quaternion &orientation, const Vector3D &scale)
+{
+    Matrix4x4 result{orientation.toMatrix()};
+    const GLfloat s[3]{scale.x, scale.y, scale.z};
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++)
+            result.matrix[row * 4 + col] *= s[col];
+    }
+    result.matrix[3] = translation.x;
+    result.matrix[7] = translation.y;
+    result.matrix[11] = translation.z;
+    return result;
+}
+
 std::tuple<Vector3D, Vector3D, Vector3D> Matrix4x4::decomposed(const Matrix4x4 &matrix)
 {
     Matrix4x4 transform = matrix;
@@ -345,14 +375,12 @@ void Matrix4x4::scale(GLfloat uniformScale)
 
 void Matrix4x4::scale(GLfloat scaleX, GLfloat scaleY, GLfloat scaleZ)
 {
-    Matrix4x4 temp =
-        {
-            scaleX, 0.f, 0.f, 0.f,
-            0.f, scaleY, 0.f, 0.f,
-            0.f, 0.f, scaleZ, 0.f,
-            0.f, 0.f, 0.f, 1.f};
-
-    *this = (*this) * temp;
+    // Same as multiplying by a scale matrix, which only scales the first three columns
+    for (int row = 0; row < 4; row++) {
+        matrix[row * 4] *= scaleX;
+        matrix[row * 4 + 1] *= scaleY;
+        matrix[row * 4 + 2] *= scaleZ;
+    }
 }
 
 GLfloat *Matrix4x4::constData()
@@ -481,26 +509,14 @@ void Matrix4x4::setRotationToVector(const Vector3D &direction, Vector3D up)
 
 void Matrix4x4::translate(GLfloat x, GLfloat y, GLfloat z)
 {
-    Matrix4x4 mat =
-        {
-            1.f, 0.f, 0.f, x,
-            0.f, 1.f, 0.f, y,
-            0.f, 0.f, 1.f, z,
-            0.f, 0.f, 0.f, 1.f};
-
-    *this = (*this) * mat;
+    // Same as multiplying by a translation matrix, which only changes the fourth column
+    for (int row = 0; row < 4; row++)
+        matrix[row * 4 + 3] = matrix[row * 4] * x + matrix[row * 4 + 1] * y + matrix[row * 4 + 2] * z + matrix[row * 4 + 3];
 }
 
 void Matrix4x4::translate(Vector3D positionIn)
 {
-    Matrix4x4 mat =
-        {
-            1.f, 0.f, 0.f, positionIn.getX(),
-            0.f, 1.f, 0.f, positionIn.getY(),
-            0.f, 0.f, 1.f, positionIn.getZ(),
-            0.f, 0.f, 0.f, 1.f};
-
-    *this = (*this) * mat;
+    translate(positionIn.getX(), positionIn.getY(), positionIn.getZ());
 }
 
 Matrix2x2 Matrix4x4::toMatrix2()
@@ -528,7 +544,7 @@ GLfloat Matrix4x4::operator()(const int &y, const int &x) const
     return matrix[y * 4 + x];
 }
 
-bool Matrix4x4::operator==(const Matrix4x4 &other)
+bool Matrix4x4::operator==(const Matrix4x4 &other) const
 {
     for (size_t i = 0; i < 16; i++)
         if (matrix[i] != other.matrix[i])
@@ -540,6 +556,7 @@ GLfloat Matrix4x4::operator[](const int num)
 {
     return matrix[num];
 }
+// The plain products are kept, simd::multiply() and simd::transform() don't beat them (see the simd benchmark)
 Matrix4x4 Matrix4x4::operator*(const Matrix4x4 &other) const
 {
     return {
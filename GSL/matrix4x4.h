@@ -10,6 +10,7 @@
 namespace gsl {
 class Matrix2x2;
 class Matrix3x3;
+class Quaternion;
 
 class Matrix4x4 {
     using vec3 = Vector3D;
@@ -23,7 +24,25 @@ public:
     bool isIdentity();
 
     bool inverse();
+    /**
+     * Faster inverse for matrices whose bottom row is 0, 0, 0, 1, like every model matrix.
+     * @return false if the matrix can't be inverted, in which case it's left unchanged.
+     */
+    bool affineInverse();
     static std::tuple<vec3, vec3, vec3> decomposed(const Matrix4x4 &matrix);
+    /**
+     * Builds Translation * Rotation * Scale directly, same as calling translate(), rotate() and scale() in that order on an identity matrix.
+     * @param translation
+     * @param rotation Euler angles in degrees
+     * @param scale
+     * @return
+     */
+    static Matrix4x4 composeTRS(const Vector3D &translation, const Vector3D &rotation, const Vector3D &scale = Vector3D(1.f, 1.f, 1.f));
+    /**
+     * @copydoc Matrix4x4::composeTRS(const Vector3D &, const Vector3D &, const Vector3D &)
+     * Rotation given as a unit quaternion, which avoids the sines and cosines of the Euler version.
+     */
+    static Matrix4x4 composeTRS(const Vector3D &translation, const Quaternion &orientation, const Vector3D &scale = Vector3D(1.f, 1.f, 1.f));
 
     void translateX(GLfloat x = 0.f);
     void translateY(GLfloat y = 0.f);
@@ -64,7 +83,7 @@ public:
 
     GLfloat &operator()(const int &y, const int &x);
     GLfloat operator()(const int &y, const int &x) const;
-    bool operator==(const Matrix4x4 &other);
+    bool operator==(const Matrix4x4 &other) const;
     GLfloat operator[](const int num);
 
     Matrix4x4 operator*(const Matrix4x4 &other) const;
@@ -0,0 +1,188 @@
+#include "quaternion.h"
+#include "gsl_math.h"
+#include "matrix4x4.h"
+
+#include <cmath>
+
+namespace gsl {
+
+namespace {
+/// Quaternion of a rotation matrix given by its upper 3x3 part, row by row.
+Quaternion fromRotation(GLfloat m00, GLfloat m01, GLfloat m02,
+                        GLfloat m10, GLfloat m11, GLfloat m12,
+                        GLfloat m20, GLfloat m21, GLfloat m22)
+{
+    // Divide by the largest of the four components to stay numerically stable
+    const GLfloat trace{m00 + m11 + m22};
+    if (trace > 0.f) {
+        const GLfloat s{std::sqrt(trace + 1.f) * 2.f};
+        return Quaternion((m21 - m12) / s, (m02 - m20) / s, (m10 - m01) / s, 0.25f * s);
+    }
+    if (m00 > m11 && m00 > m22) {
+        const GLfloat s{std::sqrt(1.f + m00 - m11 - m22) * 2.f};
+        return Quaternion(0.25f * s, (m01 + m10) / s, (m02 + m20) / s, (m21 - m12) / s);
+    }
+    if (m11 > m22) {
+        const GLfloat s{std::sqrt(1.f + m11 - m00 - m22) * 2.f};
+        return Quaternion((m01 + m10) / s, 0.25f * s, (m12 + m21) / s, (m02 - m20) / s);
+    }
+    const GLfloat s{std::sqrt(1.f + m22 - m00 - m11) * 2.f};
+    return Quaternion((m02 + m20) / s, (m12 + m21) / s, 0.25f * s, (m10 - m01) / s);
+}
+} // namespace
+
+Quaternion::Quaternion(GLfloat x_in, GLfloat y_in, GLfloat z_in, GLfloat w_in) : x{x_in}, y{y_in}, z{z_in}, w{w_in}
+{
+}
+
+Quaternion Quaternion::fromEuler(const vec3 &degrees)
+{
+    return fromAxisAngle(vec3(1.f, 0.f, 0.f), degrees.x) *
+           fromAxisAngle(vec3(0.f, 1.f, 0.f), degrees.y) *
+           fromAxisAngle(vec3(0.f, 0.f, 1.f), degrees.z);
+}
+
+Quaternion Quaternion::fromAxisAngle(vec3 axis, GLfloat degrees)
+{
+    axis.normalize();
+    const GLfloat half{deg2radf(degrees) * 0.5f};
+    const GLfloat s{std::sin(half)};
+    return Quaternion(axis.x * s, axis.y * s, axis.z * s, std::cos(half));
+}
+
+Quaternion Quaternion::fromMatrix(const Matrix4x4 &matrix)
+{
+    return fromRotation(matrix(0, 0), matrix(0, 1), matrix(0, 2),
+                        matrix(1, 0), matrix(1, 1), matrix(1, 2),
+                        matrix(2, 0), matrix(2, 1), matrix(2, 2));
+}
+
+Quaternion Quaternion::lookRotation(const vec3 &direction, const vec3 &up)
+{
+    vec3 xaxis{vec3::cross(up, direction)};
+    xaxis.normalize();
+    vec3 yaxis{vec3::cross(direction, xaxis)};
+    yaxis.normalize();
+    // The axes are the columns of the rotation matrix
+    return fromRotation(xaxis.x, yaxis.x, direction.x,
+                        xaxis.y, yaxis.y, direction.y,
+                        xaxis.z, yaxis.z, direction.z);
+}
+
+Vector3D Quaternion::toEuler() const
+{
+    // Matrix elements needed, see toMatrix()
+    const GLfloat m00{1.f - 2.f * (y * y + z * z)};
+    const GLfloat m01{2.f * (x * y - w * z)};
+    const GLfloat m02{2.f * (x * z + w * y)};
+    const GLfloat m11{1.f - 2.f * (x * x + z * z)};
+    const GLfloat m12{2.f * (y * z - w * x)};
+    const GLfloat m21{2.f * (y * z + w * x)};
+    const GLfloat m22{1.f - 2.f * (x * x + y * y)};
+
+    vec3 euler;
+    // m12 and m22 are scaled by cos(y), which keeps y precise near +-90 degrees where asin(m02) wouldn't be
+    const GLfloat cosY{std::sqrt(m12 * m12 + m22 * m22)};
+    euler.y = std::atan2(m02, cosY);
+    if (cosY > 1e-4f) {
+        euler.x = std::atan2(-m12, m22);
+        euler.z = std::atan2(-m01, m00);
+    }
+    else { // Gimbal lock, x and z rotate around the same axis
+        euler.x = std::atan2(m21, m11);
+        euler.z = 0.f;
+    }
+    return vec3(rad2degf(euler.x), rad2degf(euler.y), rad2degf(euler.z));
+}
+
+Matrix4x4 Quaternion::toMatrix() const
+{
+    return {
+        1.f - 2.f * (y * y + z * z), 2.f * (x * y - w * z), 2.f * (x * z + w * y), 0.f,
+        2.f * (x * y + w * z), 1.f - 2.f * (x * x + z * z), 2.f * (y * z - w * x), 0.f,
+        2.f * (x * z - w * y), 2.f * (y * z + w * x), 1.f - 2.f * (x * x + y * y), 0.f,
+        0.f, 0.f, 0.f, 1.f};
+}
+
+Quaternion Quaternion::operator*(const Quaternion &rhs) const
+{
+    return Quaternion(w * rhs.x + x * rhs.w + y * rhs.z - z * rhs.y,
+                      w * rhs.y - x * rhs.z + y * rhs.w + z * rhs.x,
+                      w * rhs.z + x * rhs.y - y * rhs.x + z * rhs.w,
+                      w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z);
+}
+
+Vector3D Quaternion::operator*(const vec3 &rhs) const
+{
+    const vec3 axis{x, y, z};
+    const vec3 t{vec3::cross(axis, rhs) * 2.f};
+    return rhs + t * w + vec3::cross(axis, t);
+}
+
+bool Quaternion::operator==(const Quaternion &rhs) const
+{
+    return x == rhs.x && y == rhs.y && z == rhs.z && w == rhs.w;
+}
+
+bool Quaternion::operator!=(const Quaternion &rhs) const
+{
+    return !(*this == rhs);
+}
+
+GLfloat Quaternion::length() const
+{
+    return std::sqrt(dot(*this, *this));
+}
+
+void Quaternion::normalize()
+{
+    const GLfloat l{length()};
+    if (l > 0.f) {
+        x /= l;
+        y /= l;
+        z /= l;
+        w /= l;
+    }
+}
+
+Quaternion Quaternion::normalized() const
+{
+    Quaternion q{*this};
+    q.normalize();
+    return q;
+}
+
+Quaternion Quaternion::conjugate() const
+{
+    return Quaternion(-x, -y, -z, w);
+}
+
+GLfloat Quaternion::dot(const Quaternion &q1, const Quaternion &q2)
+{
+    return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+}
+
+Quaternion Quaternion::slerp(const Quaternion &start, const Quaternion &end, GLfloat time)
+{
+    GLfloat cosAngle{dot(start, end)};
+    Quaternion target{end};
+    if (cosAngle < 0.f) { // q and -q are the same rotation, take the short way around
+        cosAngle = -cosAngle;
+        target = Quaternion(-end.x, -end.y, -end.z, -end.w);
+    }
+    GLfloat startWeight{1.f - time}, endWeight{time};
+    if (cosAngle < 0.9995f) {
+        const GLfloat angle{std::acos(cosAngle)};
+        const GLfloat sinAngle{std::sin(angle)};
+        startWeight = std::sin((1.f - time) * angle) / sinAngle;
+        endWeight = std::sin(time * angle) / sinAngle;
+    }
+    // Nearly parallel quaternions fall back to a normalized linear interpolation
+    return Quaternion(start.x * startWeight + target.x * endWeight,
+                      start.y * startWeight + target.y * endWeight,
+                      start.z * startWeight + target.z * endWeight,
+                      start.w * startWeight + target.w * endWeight)
+        .normalized();
+}
+
+} // namespace gsl
@@ -0,0 +1,76 @@
+#ifndef QUATERNION_H
+#define QUATERNION_H
+
+#include "gltypes.h"
+#include "vector3d.h"
+#include <iostream>
+
+namespace gsl {
+class Matrix4x4;
+
+/**
+ * Unit quaternion representing a rotation.
+ * Rotations combine the same way as matrices: (a * b) rotates by b first, then by a.
+ * Euler angles are in degrees and use the same order as Matrix4x4::rotateX/Y/Z, so fromEuler(e).toMatrix() equals
+ * an identity matrix after rotateX(e.x), rotateY(e.y) and rotateZ(e.z).
+ */
+class Quaternion {
+    using vec3 = Vector3D;
+
+public:
+    Quaternion(GLfloat x_in = 0.f, GLfloat y_in = 0.f, GLfloat z_in = 0.f, GLfloat w_in = 1.f);
+
+    static Quaternion fromEuler(const vec3 &degrees);
+    static Quaternion fromAxisAngle(vec3 axis, GLfloat degrees);
+    /**
+     * Rotation part of a matrix. The upper 3x3 part must be a pure rotation, without scale.
+     * @param matrix
+     * @return
+     */
+    static Quaternion fromMatrix(const Matrix4x4 &matrix);
+    /**
+     * Rotation turning the z axis towards direction, the same rotation Matrix4x4::setRotationToVector() builds.
+     * @param direction normalized
+     * @param up
+     * @return
+     */
+    static Quaternion lookRotation(const vec3 &direction, const vec3 &up = vec3(0.f, 1.f, 0.f));
+
+    /**
+     * Euler angles in degrees, in the order used by fromEuler(). Several sets of angles describe the same rotation,
+     * so this doesn't necessarily return the angles the quaternion was made from.
+     * @return
+     */
+    vec3 toEuler() const;
+    Matrix4x4 toMatrix() const;
+
+    Quaternion operator*(const Quaternion &rhs) const;
+    vec3 operator*(const vec3 &rhs) const; // Rotates the vector
+    bool operator==(const Quaternion &rhs) const;
+    bool operator!=(const Quaternion &rhs) const;
+
+    GLfloat length() const;
+    void normalize();
+    Quaternion normalized() const;
+    Quaternion conjugate() const;
+    static GLfloat dot(const Quaternion &q1, const Quaternion &q2);
+    /**
+     * Spherical interpolation along the shortest path, time between 0 and 1.
+     */
+    static Quaternion slerp(const Quaternion &start, const Quaternion &end, GLfloat time);
+
+    friend std::ostream &operator<<(std::ostream &output, const Quaternion &rhs)
+    {
+        output << "X = " << rhs.x << ", Y = " << rhs.y << ", Z = " << rhs.z << ", W = " << rhs.w;
+        return output;
+    }
+
+    GLfloat x;
+    GLfloat y;
+    GLfloat z;
+    GLfloat w;
+};
+
+} // namespace gsl
+
+#endif // QUATERNION_H
@@ -14,12 +14,6 @@ Vector2D::Vector2D(const double v) : x{static_cast<GLfloat>(v)}, y{static_cast<G
 bool Vector2D::operator==(const Vector2D &compared) const {
     return x == compared.x && y == compared.y;
 }
-const Vector2D &Vector2D::operator=(const Vector2D &rhs) {
-    x = rhs.getX();
-    y = rhs.getY();
-
-    return *this;
-}
 
 Vector2D Vector2D::operator+(const Vector2D &rhs) const {
     return {x + rhs.getX(), y + rhs.getY()};
@@ -21,7 +21,7 @@ public:
     Vector2D &operator-=(const Vector2D &rhs);      // v -= v
     Vector2D operator-() const;                     // -v
     Vector2D operator*(GLfloat lhs) const;          // v * f
-    const Vector2D &operator=(const Vector2D &rhs); // v = v
+    Vector2D &operator=(const Vector2D &rhs) = default; // v = v
     bool operator==(const Vector2D &compared) const;
 
     //Functions
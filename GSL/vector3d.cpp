@@ -14,14 +14,6 @@ Vector3D::Vector3D(const int v) : x{static_cast<float>(v)}, y{static_cast<float>
 Vector3D::Vector3D(const double v) : x{static_cast<float>(v)}, y{static_cast<float>(v)}, z{static_cast<float>(v)} {
 }
 
-const Vector3D &Vector3D::operator=(const Vector3D &rhs) {
-    x = rhs.getX();
-    y = rhs.getY();
-    z = rhs.getZ();
-
-    return *this;
-}
-
 Vector3D Vector3D::operator+(const Vector3D &rhs) const {
     return {x + rhs.getX(), y + rhs.getY(), z + rhs.getZ()};
 }
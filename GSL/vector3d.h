@@ -17,7 +17,7 @@ public:
     Vector3D(const double v);
 
     //Operators
-    const Vector3D &operator=(const Vector3D &rhs); // v = v
+    Vector3D &operator=(const Vector3D &rhs) = default; // v = v
     Vector3D operator+(const Vector3D &rhs) const;  // v + v
     Vector3D operator-(const Vector3D &rhs) const;  // v - v
     Vector3D operator/(const Vector3D &rhs) const;
@@ -33,15 +33,6 @@ void Vector4D::clipNormalize() {
     z *= w;
 }
 
-const Vector4D &Vector4D::operator=(const Vector4D &rhs) {
-    x = rhs.getX();
-    y = rhs.getY();
-    z = rhs.getZ();
-    w = rhs.getW();
-
-    return *this;
-}
-
 Vector4D Vector4D::operator+(const Vector4D &rhs) const {
     return {x + rhs.getX(), y + rhs.getY(), z + rhs.getZ(), w + rhs.getW()};
 }
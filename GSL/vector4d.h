@@ -24,7 +24,7 @@ public:
     void clipNormalize();
 
     //Operators:
-    const Vector4D &operator=(const Vector4D &rhs); // v = v
+    Vector4D &operator=(const Vector4D &rhs) = default; // v = v
     Vector4D operator+(const Vector4D &rhs) const;  // v + v
     Vector4D operator-(const Vector4D &rhs) const;  // v - v
     Vector4D &operator+=(const Vector4D &rhs);      // v += v
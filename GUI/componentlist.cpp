@@ -876,6 +876,13 @@ QComboBox *ComponentList::makeObjectTypeBox(QGroupBox *objectTypeBox, const Coll
     CollisionSystem *colSys{registry->system<CollisionSystem>().get()};
     connect(staticBox, SIGNAL(currentIndexChanged(int)), colSys, SLOT(setObjectType(int)));
     objectType->addWidget(staticBox);
+
+    // Same order as the CollisionLayer enum
+    QComboBox *layerBox{new QComboBox};
+    layerBox->addItems({"Default", "Level", "Decoration", "Tower", "Tower Range", "Enemy", "Bullet"});
+    layerBox->setCurrentIndex(static_cast<int>(col.layer));
+    connect(layerBox, SIGNAL(currentIndexChanged(int)), colSys, SLOT(setCollisionLayer(int)));
+    objectType->addWidget(layerBox);
     objectTypeBox->setLayout(objectType);
     return staticBox;
 }
@@ -1,6 +1,7 @@
 #include "hierarchymodel.h"
 #include <QDebug>
 #include <QMimeData>
+#include <unordered_set>
 
 HierarchyModel::HierarchyModel()
 {
@@ -38,6 +39,26 @@ void HierarchyModel::removeEntity(GLuint eID)
     }
 }
 
+/**
+ * @brief Slot to remove a batch of items from the tree view, going through the tree once instead of once per entity.
+ * @param entities
+ */
+void HierarchyModel::removeEntities(const std::vector<GLuint> &entities)
+{
+    const std::unordered_set<GLuint> removed(entities.cbegin(), entities.cend());
+    for (int i = rowCount() - 1; i >= 0; i--) {
+        QStandardItem *item{itemFromIndex(this->index(i, 0))};
+        if (removed.count(item->data().toUInt())) {
+            removeRow(i);
+            continue;
+        }
+        for (int j = item->rowCount() - 1; j >= 0; j--) {
+            if (removed.count(item->child(j)->data().toUInt()))
+                item->removeRow(j);
+        }
+    }
+}
+
 QStandardItem *HierarchyModel::itemFromEntityID(GLuint eID)
 {
     for (int i = 0; i < rowCount(); i++) {
@@ -2,6 +2,7 @@
 #define HIERARCHYMODEL_H
 #include "gltypes.h"
 #include <QStandardItemModel>
+#include <vector>
 class QMimeData;
 
 class HierarchyModel : public QStandardItemModel {
@@ -12,6 +13,7 @@ public:
 
 public slots:
     void removeEntity(GLuint eID);
+    void removeEntities(const std::vector<GLuint> &entities);
 signals:
     void parentChanged(const QModelIndex &index);
 
@@ -0,0 +1,211 @@
+# Everything the engine is built from except main(), shared by the editor and the benchmarks.
+QT          += core gui widgets qml
+CONFIG      += c++17
+
+# Store components in archetype tables instead of one Pool per component type
+# DEFINES     += CJK_ARCHETYPE_STORAGE
+
+PRECOMPILED_HEADER = $$PWD/innpch.h
+
+INCLUDEPATH += \
+    $$PWD/GSL \
+    $$PWD/ECS \
+    $$PWD/ECS/Systems \
+    $$PWD/ECS/Views \
+    $$PWD/Shaders \
+    $$PWD/Systems \
+    $$PWD/Views \
+    $$PWD/GUI \
+    $$PWD/Resources \
+    $$PWD/Libs \
+
+mac {
+    LIBS += -framework OpenAL
+}
+
+win32 {
+    INCLUDEPATH += $(OPENAL_HOME)\\include\\AL
+
+    #Visual Studio 64-bit
+    contains(QT_ARCH, x86_64) {
+        LIBS *= $(OPENAL_HOME)\\libs\\Win64\\OpenAL32.lib
+        # Copy required DLLs to output directory
+        CONFIG(debug, debug|release) {
+            OpenAL32.commands = copy /Y \"$(OPENAL_HOME)\\bin\\Win64\\OpenAL32.dll\" debug
+            OpenAL32.target = debug/OpenAL32.dll
+
+            QMAKE_EXTRA_TARGETS += OpenAL32
+            PRE_TARGETDEPS += debug/OpenAL32.dll
+        } else:CONFIG(release, debug|release) {
+            OpenAL32.commands = copy /Y \"$(OPENAL_HOME)\\bin\\Win64\\OpenAL32.dll\" release
+            OpenAL32.target = release/OpenAL32.dll
+
+            QMAKE_EXTRA_TARGETS += OpenAL32
+            PRE_TARGETDEPS += release/OpenAL32.dll release/OpenAL32.dll
+        } else {
+            error(Unknown set of dependencies.)
+        }
+    } else {
+        LIBS *= $(OPENAL_HOME)\\libs\\Win32\\OpenAL32.lib
+        # Copy required DLLs to output directory
+        CONFIG(debug, debug|release) {
+            OpenAL32.commands = copy /Y \"$(OPENAL_HOME)\\bin\\Win32\\OpenAL32.dll\" debug
+            OpenAL32.target = debug/OpenAL32.dll
+
+            QMAKE_EXTRA_TARGETS += OpenAL32
+            PRE_TARGETDEPS += debug/OpenAL32.dll
+        } else:CONFIG(release, debug|release) {
+            OpenAL32.commands = copy /Y \"$(OPENAL_HOME)\\bin\\Win32\\OpenAL32.dll\" release
+            OpenAL32.target = release/OpenAL32.dll
+
+            QMAKE_EXTRA_TARGETS += OpenAL32
+            PRE_TARGETDEPS += release/OpenAL32.dll release/OpenAL32.dll
+        } else {
+            error(Unknown set of dependencies.)
+        }
+    }
+}
+
+HEADERS += \
+    $$PWD/ECS/Systems/isystem.h \
+    $$PWD/ECS/Systems/aisystem.h \
+    $$PWD/ECS/Systems/inputsystem.h \
+    $$PWD/ECS/Systems/particlesystem.h \
+    $$PWD/ECS/Systems/scriptsystem.h \
+    $$PWD/ECS/Systems/soundsystem.h \
+    $$PWD/ECS/Systems/rendersystem.h \
+    $$PWD/ECS/Systems/movementsystem.h \
+    $$PWD/ECS/Systems/collisionsystem.h \
+#
+    $$PWD/ECS/archetype.h \
+    $$PWD/ECS/commandbuffer.h \
+    $$PWD/ECS/entity.h \
+    $$PWD/ECS/family.h \
+    $$PWD/ECS/group.h \
+    $$PWD/ECS/pool.h \
+    $$PWD/ECS/sparseset.h \
+    $$PWD/ECS/threadpool.h \
+    $$PWD/ECS/transformstreams.h \
+    $$PWD/ECS/spatialgrid.h \
+    $$PWD/ECS/bvh.h \
+    $$PWD/ECS/sweepandprune.h \
+    $$PWD/ECS/paircache.h \
+    $$PWD/ECS/view.h \
+    $$PWD/ECS/components.h \
+    $$PWD/ECS/registry.h \
+    $$PWD/ECS/scheduler.h \
+#
+    $$PWD/GSL/matrix2x2.h \
+    $$PWD/GSL/matrix3x3.h \
+    $$PWD/GSL/matrix4x4.h \
+    $$PWD/GSL/vector2d.h \
+    $$PWD/GSL/vector3d.h \
+    $$PWD/GSL/vector4d.h \
+    $$PWD/GSL/gsl_math.h \
+    $$PWD/GSL/vertex.h \
+    $$PWD/GSL/math_constants.h \
+    $$PWD/GSL/gsl_simd.h \
+    $$PWD/GSL/quaternion.h \
+#
+    $$PWD/GUI/componentgroupbox.h \
+    $$PWD/GUI/componentlist.h \
+    $$PWD/GUI/customdoublespinbox.h \
+    $$PWD/GUI/customspinbox.h \
+    $$PWD/GUI/hierarchymodel.h \
+    $$PWD/GUI/hierarchyview.h \
+    $$PWD/GUI/verticalscrollarea.h \
+#    
+    $$PWD/Shaders/colorshader.h \
+    $$PWD/Shaders/particleshader.h \
+    $$PWD/Shaders/skyboxshader.h \
+    $$PWD/Shaders/textureshader.h \
+    $$PWD/Shaders/phongshader.h \
+    $$PWD/Shaders/shader.h \
+#
+    $$PWD/Resources/scene.h \
+    $$PWD/Resources/resourcemanager.h \
+    $$PWD/Resources/texture.h \
+#
+    $$PWD/Libs/tiny_obj_loader.h \
+    $$PWD/Libs/stb_image.h \
+    $$PWD/Libs/wavfilehandler.h \
+#
+    $$PWD/bsplinecurve.h \
+    $$PWD/cameracontroller.h \
+    $$PWD/constants.h \
+    $$PWD/core.h \
+    $$PWD/core.h \
+    $$PWD/deltaTime.h \
+    $$PWD/deltaTime.h \
+    $$PWD/hud.h \
+    $$PWD/renderwindow.h \
+    $$PWD/mainwindow.h \
+    $$PWD/camera.h \
+    $$PWD/gltypes.h
+
+
+SOURCES += \
+    $$PWD/ECS/Systems/aisystem.cpp \
+    $$PWD/ECS/Systems/inputsystem.cpp \
+    $$PWD/ECS/Systems/particlesystem.cpp \
+    $$PWD/ECS/Systems/scriptsystem.cpp \
+    $$PWD/ECS/Systems/soundsystem.cpp \
+    $$PWD/ECS/Systems/rendersystem.cpp \
+    $$PWD/ECS/Systems/movementsystem.cpp \
+    $$PWD/ECS/Systems/collisionsystem.cpp \
+#
+    $$PWD/ECS/commandbuffer.cpp \
+    $$PWD/ECS/components.cpp \
+    $$PWD/ECS/registry.cpp \
+    $$PWD/ECS/scheduler.cpp \
+    $$PWD/ECS/threadpool.cpp \
+    $$PWD/ECS/spatialgrid.cpp \
+    $$PWD/ECS/bvh.cpp \
+    $$PWD/ECS/sweepandprune.cpp \
+    $$PWD/ECS/paircache.cpp \
+#
+    $$PWD/GSL/matrix2x2.cpp \
+    $$PWD/GSL/matrix3x3.cpp \
+    $$PWD/GSL/matrix4x4.cpp \
+    $$PWD/GSL/vector2d.cpp \
+    $$PWD/GSL/vector3d.cpp \
+    $$PWD/GSL/vector4d.cpp \
+    $$PWD/GSL/vertex.cpp \
+    $$PWD/GSL/gsl_math.cpp \
+    $$PWD/GSL/gsl_simd.cpp \
+    $$PWD/GSL/quaternion.cpp \
+#
+    $$PWD/GUI/componentgroupbox.cpp \
+    $$PWD/GUI/componentlist.cpp \
+    $$PWD/GUI/customdoublespinbox.cpp \
+    $$PWD/GUI/customspinbox.cpp \
+    $$PWD/GUI/hierarchymodel.cpp \
+    $$PWD/GUI/hierarchyview.cpp \
+    $$PWD/GUI/verticalscrollarea.cpp \
+#
+    $$PWD/Shaders/colorshader.cpp \
+    $$PWD/Shaders/particleshader.cpp \
+    $$PWD/Shaders/skyboxshader.cpp \
+    $$PWD/Shaders/textureshader.cpp \
+    $$PWD/Shaders/phongshader.cpp \
+    $$PWD/Shaders/shader.cpp \
+#
+    $$PWD/Resources/resourcemanager.cpp \
+    $$PWD/Resources/texture.cpp \
+    $$PWD/Resources/scene.cpp \
+#
+    $$PWD/Libs/wavfilehandler.cpp \
+    $$PWD/Libs/stb_image.cpp \
+#
+    $$PWD/bsplinecurve.cpp \
+    $$PWD/cameracontroller.cpp \
+    $$PWD/hud.cpp \
+    $$PWD/renderwindow.cpp \
+    $$PWD/mainwindow.cpp \
+    $$PWD/camera.cpp
+
+FORMS += \
+    $$PWD/mainwindow.ui
+
+RESOURCES += \
+    $$PWD/icons.qrc
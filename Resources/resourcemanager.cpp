@@ -1,6 +1,7 @@
 #include "resourcemanager.h"
 #include "aisystem.h"
 #include "cameracontroller.h"
+#include "collisionsystem.h"
 #include "colorshader.h"
 #include "hud.h"
 #include "innpch.h"
@@ -37,6 +38,7 @@ ResourceManager::ResourceManager() : registry{Registry::instance()}
 
     registry->registerComponent<EInfo>();
     registry->registerComponent<Transform>();
+    registry->registerComponent<Velocity>();
     registry->registerComponent<Material>();
     registry->registerComponent<Mesh>();
     registry->registerComponent<ParticleEmitter>();
@@ -369,7 +371,7 @@ GLuint ResourceManager::makeEnemy(const QString &name)
 {
     GLuint eID{registry->makeEntity<Mesh, AIComponent>(name)};
     registry->add<Transform>(eID, vec3{}, vec3{}, vec3{0.3f, 0.3f, 0.3f});
-    auto &aabb{registry->add<AABB>(eID, vec3{0.f, 0.8f, -0.1f}, vec3{0.5f, 0.8f, 0.3f}, false)};
+    auto &aabb{registry->add<AABB>(eID, vec3{0.f, 0.8f, -0.1f}, vec3{0.5f, 0.8f, 0.3f}, false, CollisionLayer::ENEMY)};
     aabb.overlapEvent = true;
     auto &sound{registry->add<Sound>(eID, "gnomed.wav", true)};
     sound.playing = true;
@@ -381,7 +383,8 @@ GLuint ResourceManager::makeEnemy(const QString &name)
 GLuint ResourceManager::makeTower(const QString &name)
 {
     GLuint eID{registry->makeEntity<Transform, Mesh, TowerComponent, AABB>(name)};
-    registry->add<Sphere>(eID, vec3{}, 4.f, false);
+    registry->get<AABB>(eID).layer = CollisionLayer::TOWER;
+    registry->add<Sphere>(eID, vec3{}, 4.f, false, CollisionLayer::TOWER_RANGE);
     registry->add<Material>(eID, getShader<ColorShader>(), 0); // change this when we have a tower mesh!
     setMesh("cube.obj", eID);
     return eID;
@@ -391,7 +394,7 @@ GLuint ResourceManager::makeLevelPlane(const QString &name)
 {
     GLuint eID{registry->makeEntity<Mesh, Buildable>(name)};
     registry->add<Transform>(eID, vec3{0}, vec3{}, vec3{2.5f, 1.f, 2.5f});
-    registry->add<AABB>(eID, vec3{}, vec3{2.5f, 0.01f, 2.5f}, true);
+    registry->add<AABB>(eID, vec3{}, vec3{2.5f, 0.01f, 2.5f}, true, CollisionLayer::LEVEL);
     setMesh("Plane", eID);
     registry->add<Material>(eID, getShader<PhongShader>(), 0u, vec3{.57f, .57f, .57f});
     return eID;
@@ -575,9 +578,15 @@ void ResourceManager::makeLightMesh(int eID)
 
     glBindVertexArray(0);
 }
-void ResourceManager::setAABBMesh(Mesh &mesh)
+Mesh ResourceManager::getColliderBoxMesh()
 {
+    auto search{mMeshMap.find("BoxCollider")};
+    if (search != mMeshMap.end())
+        return search->second;
+
+    initializeOpenGLFunctions();
     mMeshData.Clear();
+    mMeshData.name = "BoxCollider";
 
     mMeshData.vertices.insert(mMeshData.vertices.end(),
                               {
@@ -609,13 +618,13 @@ void ResourceManager::setAABBMesh(Mesh &mesh)
                                   Vertex{vec3{-1.0f, 1.0f, 1.0f}, vec3{0.f, 1.f, 0.f}, gsl::Vector2D{0.5f, 0.5f}},  //Back low
                                   Vertex{vec3{-1.0f, 1.0f, -1.0f}, vec3{0.f, 1.f, 0.f}, gsl::Vector2D{0.5f, 0.5f}}  //Back low
                               });
-    mesh.name = "BoxCollider";
-    mesh.verticeCount = mMeshData.vertices.size();
-    mesh.indiceCount = mMeshData.indices.size();
-    mesh.drawType = GL_LINE_STRIP;
+    Mesh boxMesh{GL_LINE_STRIP, mMeshData};
+    initVertexBuffers(&boxMesh);
+    initIndexBuffers(&boxMesh);
+    glBindVertexArray(0);
 
-    initVertexBuffers(&mesh);
-    initIndexBuffers(&mesh);
+    mMeshMap["BoxCollider"] = boxMesh;
+    return boxMesh;
 }
 
 void ResourceManager::initVertexBuffers(Mesh *mesh)
@@ -864,6 +873,26 @@ Mesh ResourceManager::getMesh(std::string meshName)
     return mMeshMap[meshName];
 }
 
+Mesh ResourceManager::getBallMesh(int n)
+{
+    auto search{mMeshMap.find("Ball")};
+    if (search != mMeshMap.end())
+        return search->second;
+
+    initializeOpenGLFunctions();
+    mMeshData.Clear();
+    mMeshData.name = "Ball";
+    makeUnitOctahedron(n); // This fills mMeshData
+
+    Mesh ballMesh{GL_TRIANGLES, mMeshData};
+    initVertexBuffers(&ballMesh);
+    initIndexBuffers(&ballMesh);
+    glBindVertexArray(0);
+
+    mMeshMap["Ball"] = ballMesh;
+    return ballMesh;
+}
+
 bool ResourceManager::readFile(std::string fileName, int eID)
 {
     //Open File
@@ -1146,10 +1175,11 @@ void ResourceManager::pause()
 void ResourceManager::stop()
 {
     if (mIsPlaying || mIsPaused) {
-        auto [movement, sound, input]{registry->system<MovementSystem, SoundSystem, InputSystem>()};
+        auto [movement, sound, input, collision]{registry->system<MovementSystem, SoundSystem, InputSystem, CollisionSystem>()};
         sound->stopAll();
         sound->refreshSounds();
         registry->loadSnapshot();
+        collision->bakeStaticColliders(); // Towers placed while playing are gone
 
         movement->init();
         input->setGameCameraInactive();
@@ -103,6 +103,13 @@ public:
      * @return
      */
     Mesh getMesh(std::string meshName);
+    /**
+     * Get a copy of the ball mesh, making it the first time it's asked for.
+     * Lets a ball be given its mesh through a CommandBuffer, without an entity to build the mesh on.
+     * @param n Degree of roundness, only used the first time.
+     * @return
+     */
+    Mesh getBallMesh(int n = 3);
 
     void setLoading(bool load) { mLoading = load; }
 
@@ -245,10 +252,11 @@ public:
      */
     void initParticleEmitter(ParticleEmitter &emitter);
     /**
-     * Gives a mesh to an AABB collider.
-     * @param mesh
+     * Line mesh of a unit cube from -1 to 1, drawn for every AABB collider with the collider's model matrix.
+     * Shared by every collider, and only made the first time it's needed.
+     * @return
      */
-    void setAABBMesh(Mesh &mesh);
+    Mesh getColliderBoxMesh();
     /**
      * Creates a new empty scene.
      * @param text
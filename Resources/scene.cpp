@@ -1,5 +1,6 @@
 #include "scene.h"
 #include "cameracontroller.h"
+#include "collisionsystem.h"
 #include "colorshader.h"
 #include "constants.h"
 #include "core.h"
@@ -33,6 +34,14 @@ void Scene::saveScene(const QString &fileName)
 
     mName = fileName;
     writer.StartObject();
+    // Per level settings
+    writer.Key("Settings");
+    writer.StartObject();
+    if (auto collisionSys{registry->system<CollisionSystem>()}) {
+        writer.Key("cellsize");
+        writer.Double(collisionSys->cellSize());
+    }
+    writer.EndObject();
 
     for (auto &entity : entities) {
         const EInfo info{registry->get<EInfo>(entity)};
@@ -75,10 +84,10 @@ void Scene::saveScene(const QString &fileName)
                 writer.Key("parent");
                 writer.Int(trans.parentID);
 
-                if (!trans.children.empty()) {
+                if (trans.firstChild != -1) {
                     writer.Key("children");
                     writer.StartArray();
-                    for (auto child : trans.children) {
+                    for (auto child : registry->getChildren(entity)) {
                         writer.Int(child);
                     }
                     writer.EndArray();
@@ -242,6 +251,10 @@ void Scene::saveScene(const QString &fileName)
                 writer.EndArray();
                 writer.Key("static");
                 writer.Bool(aabb.isStatic);
+                writer.Key("layer");
+                writer.Int(static_cast<int>(aabb.layer));
+                writer.Key("mask");
+                writer.Uint(aabb.mask);
                 writer.EndObject();
             }
             if (registry->contains<Sphere>(entity)) {
@@ -259,6 +272,10 @@ void Scene::saveScene(const QString &fileName)
                 writer.Double(sphere.radius);
                 writer.Key("static");
                 writer.Bool(sphere.isStatic);
+                writer.Key("layer");
+                writer.Int(static_cast<int>(sphere.layer));
+                writer.Key("mask");
+                writer.Uint(sphere.mask);
                 writer.EndObject();
             }
             if (registry->contains<AIComponent>(entity)) {
@@ -341,20 +358,30 @@ void Scene::loadScene(const QString &fileName)
     }
     mName = fileName.chopped(5);
     registry->updateChildParent();
+    if (auto collisionSys{registry->system<CollisionSystem>()})
+        collisionSys->bakeStaticColliders();
     factory->setLoading(false);
 }
 void Scene::populateScene(const Document &scene)
 {
     std::map<int, int> parentID;
     std::map<int, int> idPairs;
+    std::vector<GLuint> entities;
     Registry *registry{Registry::instance()};
     ResourceManager *factory{ResourceManager::instance()};
+    if (scene.HasMember("Settings") && scene["Settings"].HasMember("cellsize")) {
+        if (auto collisionSys{registry->system<CollisionSystem>()})
+            collisionSys->setCellSize(scene["Settings"]["cellsize"].GetFloat());
+    }
     if (!scene.HasMember("Entity"))
         return;
     // Iterate through each entity in the scene
     for (Value::ConstMemberIterator itr = scene.MemberBegin(); itr != scene.MemberEnd(); ++itr) {
-        GLuint id{registry->makeEntity(itr->value["name"].GetString())};
+        if (itr->name != "Entity")
+            continue;
+        GLuint id{registry->makeEntity(itr->value["name"].GetString(), false)};
         idPairs[itr->value["id"].GetInt()] = id;
+        entities.push_back(id);
         // Iterate through each of the members in the entity (name, id, components)
         for (Value::ConstMemberIterator comp{itr->value["components"].MemberBegin()}; comp != itr->value["components"].MemberEnd(); ++comp) {
             if (comp->name == "transform") {
@@ -431,13 +458,17 @@ void Scene::populateScene(const Document &scene)
                 vec3 origin{comp->value["origin"][0].GetFloat(), comp->value["origin"][1].GetFloat(), comp->value["origin"][2].GetFloat()};
                 vec3 size{comp->value["size"][0].GetFloat(), comp->value["size"][1].GetFloat(), comp->value["size"][2].GetFloat()};
                 bool isStatic{comp->value["static"].GetBool()};
-                registry->add<AABB>(id, origin, size, isStatic);
+                auto &aabb{registry->add<AABB>(id, origin, size, isStatic)};
+                loadLayer(comp->value, aabb);
+                // Scenes saved before there were collision layers have their level tiles on the default layer
+                if (!comp->value.HasMember("layer") && itr->value["components"].HasMember("Buildable"))
+                    aabb.layer = CollisionLayer::LEVEL;
             }
             else if (comp->name == "Sphere") {
                 vec3 position{comp->value["position"][0].GetFloat(), comp->value["position"][1].GetFloat(), comp->value["position"][2].GetFloat()};
                 float radius{comp->value["radius"].GetFloat()};
                 bool isStatic{comp->value["static"].GetBool()};
-                registry->add<Sphere>(id, position, radius, isStatic);
+                loadLayer(comp->value, registry->add<Sphere>(id, position, radius, isStatic));
             }
             else if (comp->name == "AI") {
                 int hp{comp->value["health"].GetInt()};
@@ -466,6 +497,18 @@ void Scene::populateScene(const Document &scene)
         //We can find the new id of that object by searching idPairs using Pair value as the key.
         registry->get<Transform>(pair.first).parentID = idPairs[pair.second];
     }
+    // Let the editor know about the whole scene at once instead of one entity at a time
+    emit registry->entitiesCreated(entities);
+}
+void Scene::loadLayer(const Value &collider, Collision &col)
+{
+    if (collider.HasMember("layer")) {
+        const int layer{collider["layer"].GetInt()};
+        if (layer >= 0 && layer < static_cast<int>(CollisionLayer::COUNT))
+            col.layer = static_cast<CollisionLayer>(layer);
+    }
+    if (collider.HasMember("mask"))
+        col.mask = collider["mask"].GetUint();
 }
 void Scene::loadSceneFromFile(const QString &fileName)
 {
@@ -13,6 +13,7 @@ class Vector3D;
 using namespace rapidjson;
 class ResourceManager;
 class Registry;
+struct Collision;
 class Scene {
     using vec3 = gsl::Vector3D;
 
@@ -54,6 +55,12 @@ private:
      * @param scene
      */
     void populateScene(const Document &scene);
+    /**
+     * Reads a collider's layer and mask, which older scenes don't have.
+     * @param collider the collider's .json object
+     * @param col
+     */
+    static void loadLayer(const Value &collider, Collision &col);
 };
 
 #endif // SCENE_H
@@ -80,15 +80,12 @@ void BSplineCurve::updatePath(bool init)
         }
     }
     if (init) {
-        std::vector<Transform *> temp;
+        size_t i{0};
         for (auto entity : view) {
             auto &bspline{view.get<Transform>(entity)};
-            temp.push_back(&bspline);
-        }
-        for (size_t i{0}; i < temp.size(); i++) {
-            temp[i]->localPosition = localPos[i];
-            temp[i]->localPosition.y += 0.5f;
-            temp[i]->matrixOutdated = true;
+            bspline.localPosition = localPos[i++];
+            bspline.localPosition.y += 0.5f;
+            Registry::instance()->transforms().markDirty(entity);
         }
     }
     // Control points
@@ -68,7 +68,7 @@ gsl::Vector3D Camera::calculateMouseRay(const vec3 &viewportPoint, int height, i
     rayEye = vec4{rayEye.x, rayEye.y, -1.0, 0.0};
 
     gsl::Matrix4x4 viewMatrix{mViewMatrix};
-    viewMatrix.inverse();
+    viewMatrix.affineInverse(); // The view matrix is a rotation and a translation
     vec3 rayWorld{(viewMatrix * rayEye).getXYZ()};
     rayWorld.normalize();
 
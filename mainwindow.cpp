@@ -105,8 +105,9 @@ void MainWindow::init()
     connect(hView, &HierarchyView::clicked, this, &MainWindow::onEntityClicked);
 
     connect(this, &MainWindow::selectedEntity, registry, &Registry::setSelectedEntity);
-    connect(registry, &Registry::entityCreated, this, &MainWindow::onEntityAdded);
-    connect(registry, &Registry::entityRemoved, hierarchy, &HierarchyModel::removeEntity);
+    connect(registry, &Registry::entitiesCreated, this, &MainWindow::onEntitiesAdded);
+    connect(registry, &Registry::entitiesRemoved, hierarchy, &HierarchyModel::removeEntities);
+    connect(registry, &Registry::nameChanged, this, &MainWindow::changeEntityName);
     connect(registry, &Registry::parentChanged, this, &MainWindow::parentChanged);
     connect(ResourceManager::instance(), &ResourceManager::addedMesh, this, &MainWindow::onMeshAdded);
     connect(this, &MainWindow::renderStatus, mRenderWindow, &RenderWindow::toggleRendered);
@@ -443,8 +444,11 @@ void MainWindow::onEntityAdded(GLuint eID)
     item->setData(eID, IDRole);
     item->setCheckable(true);
     parentItem->appendRow(item);
-
-    connect(registry, &Registry::nameChanged, this, &MainWindow::changeEntityName);
+}
+void MainWindow::onEntitiesAdded(const std::vector<GLuint> &entities)
+{
+    for (auto entity : entities)
+        onEntityAdded(entity);
 }
 void MainWindow::onMeshAdded(GLuint eID)
 {
@@ -488,8 +492,6 @@ void MainWindow::insertEntities()
     QStandardItem *parentItem{hierarchy->invisibleRootItem()};
     for (auto entity : registry->getEntities()) {
         auto &info{registry->get<EInfo>(entity)};
-        if (info.isDestroyed)
-            continue;
         QStandardItem *item{new QStandardItem};
         if (info.name == "")
             item->setText(QString("Entity"));
@@ -71,6 +71,7 @@ private slots:
 
     void onDataChanged(const QModelIndex &index, const QModelIndex &otherIndex = QModelIndex(), const QVector<int> roles = QVector<int>());
     void onEntityAdded(GLuint entity);
+    void onEntitiesAdded(const std::vector<GLuint> &entities);
     void onEntityRemoved(GLuint entity);
 
     void onParentChanged(const QModelIndex &index);
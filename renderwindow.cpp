@@ -9,6 +9,7 @@
 #include "movementsystem.h"
 #include "particlesystem.h"
 #include "rendersystem.h"
+#include "scheduler.h"
 #include "scriptsystem.h"
 #include "soundsystem.h"
 
@@ -163,6 +164,36 @@ void RenderWindow::init()
     connect(mInputSystem.get(), &InputSystem::toggleRendered, mRenderer.get(), &RenderSystem::toggleRendered);
     connect(mRenderer.get(), &RenderSystem::newRenderedSignal, mMainWindow, &MainWindow::updateRenderedCheckBox);
 
+    // Stages are added in the order they used to be called in. Stages touching the same components still run in this order,
+    // e.g. SoundSystem's play-only stage has to read the outdated Transforms before MovementSystem updates them.
+    using Mode = Scheduler::Mode;
+    mScheduler = std::make_unique<Scheduler>();
+    mScheduler->setTickRate(TickRate);
+    mScheduler->setMaxTicksPerFrame(MaxTicksPerFrame);
+    // The simulation, run at the fixed tick rate while playing. MovementSystem saves the matrices to blend from first,
+    // and brings the world matrices up to date again before the collisions are checked.
+    mScheduler->addFixed("Movement (tick)", mMoveSystem, [this](DeltaTime dt) { mMoveSystem->updateFixed(dt); });
+    mScheduler->addFixed("AI (tick)", mAISystem, [this](DeltaTime dt) { mAISystem->updatePlayOnly(dt); });
+    mScheduler->addFixed("Sound (tick)", mSoundSystem, [this](DeltaTime) { mSoundSystem->updatePlayOnly(); });
+    mScheduler->addFixed("Transforms (tick)", mMoveSystem, [this](DeltaTime dt) { mMoveSystem->update(dt); });
+    mScheduler->addFixed("Collision (tick)", mCollisionSystem, [this](DeltaTime dt) { mCollisionSystem->updatePlayOnly(dt); });
+    mScheduler->addFixed("Particles (tick)", mParticleSystem, [this](DeltaTime dt) { mParticleSystem->updateFixed(dt); });
+    // Everything else runs once per frame
+    mScheduler->add("Render", mRenderer, [this](DeltaTime dt) {
+        mRenderer->setInterpolation(mScheduler->alpha());
+        mRenderer->update(dt);
+    });
+    mScheduler->add("Sound", mSoundSystem, [this](DeltaTime dt) { mSoundSystem->update(dt); });
+    mScheduler->add("Input", mInputSystem, [this](DeltaTime dt) { mInputSystem->update(dt); });
+    mScheduler->add("AI", mAISystem, [this](DeltaTime dt) { mAISystem->update(dt); });
+    mScheduler->add("Particles", mParticleSystem, [this](DeltaTime dt) { mParticleSystem->update(dt); });
+    mScheduler->add("AI (editor)", mAISystem, [this](DeltaTime dt) { mAISystem->updateEditorOnly(dt); }, Mode::EditorOnly);
+    mScheduler->add("Render (editor)", mRenderer, [this](DeltaTime) { mRenderer->updateEditorOnly(); }, Mode::EditorOnly);
+    mScheduler->add("Input (play)", mInputSystem, [this](DeltaTime dt) { mInputSystem->updatePlayOnly(dt); }, Mode::PlayOnly);
+    mScheduler->add("Particles (play)", mParticleSystem, [this](DeltaTime dt) { mParticleSystem->updatePlayOnly(dt); }, Mode::PlayOnly);
+    mScheduler->add("Movement", mMoveSystem, [this](DeltaTime dt) { mMoveSystem->update(dt); });
+    mScheduler->add("Collision", mCollisionSystem, [this](DeltaTime dt) { mCollisionSystem->update(dt); });
+
     HUD hud;
     hud.updatehealth();
 }
@@ -182,24 +213,8 @@ void RenderWindow::render()
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     if (!mFactory->isLoading()) { // Not sure if this is necessary, but we wouldn't want to try rendering something before the scene is done loading everything
-        mRenderer->update(dt);
-        mSoundSystem->update(dt);
-        mInputSystem->update(dt);
-        mAISystem->update(dt);
-        mParticleSystem->update(dt);
-        if (mFactory->isPaused() || !mFactory->isPlaying()) {
-            mAISystem->updateEditorOnly(dt);
-            mRenderer->updateEditorOnly();
-        }
-        else {
-            mInputSystem->updatePlayOnly(dt);
-            mAISystem->updatePlayOnly(dt);
-            mCollisionSystem->updatePlayOnly(dt);
-            mParticleSystem->updatePlayOnly(dt);
-            mSoundSystem->updatePlayOnly();
-        }
-        mMoveSystem->update(dt);
-        mCollisionSystem->update(dt);
+        mScheduler->run(dt, mFactory->isPlaying() && !mFactory->isPaused());
+        mRegistry->flush(); // Apply anything the systems recorded in their command buffers
     }
     //Calculate framerate before
     // checkForGLerrors() because that takes a long time
@@ -229,8 +244,10 @@ void RenderWindow::exposeEvent(QExposeEvent *)
     //isExposed() is a function in QWindow
     if (isExposed()) {
         //This timer runs the actual MainLoop
-        //16 means 16ms = 60 Frames pr second (should be 16.6666666 to be exact..)
-        mRenderTimer->start(1);
+        //Capped at MaxFrameRate so the loop doesn't spin as fast as Qt can fire it when vsync is off.
+        //The simulation runs at its own fixed rate regardless, see Scheduler.
+        mRenderTimer->setTimerType(Qt::PreciseTimer);
+        mRenderTimer->start(1000 / MaxFrameRate);
         mTimeStart.start();
     }
     //This is just to support modern screens with "double" pixels
@@ -294,10 +311,17 @@ void RenderWindow::calculateFramerate()
         if (frameCount > 30) //once pr 30 frames = update the message twice pr second (on a 60Hz monitor)
         {
             if (!mMainWindow->showingMsg()) {
+                // find the system stage that took the longest last frame
+                std::pair<QString, double> slowest{"", 0};
+                for (auto &stage : mScheduler->timings()) {
+                    if (stage.second > slowest.second)
+                        slowest = stage;
+                }
                 //showing some statistics in status bar
                 mMainWindow->statusBar()->showMessage(" Time pr FrameDraw: " +
                                                       QString::number(nsecElapsed / 1000000., 'g', 4) + " ms  |  " +
-                                                      "FPS (approximated): " + QString::number(1E9 / nsecElapsed, 'g', 7));
+                                                      "FPS (approximated): " + QString::number(1E9 / nsecElapsed, 'g', 7) + "  |  " +
+                                                      "Slowest system: " + slowest.first + " " + QString::number(slowest.second, 'g', 3) + " ms");
             }
             frameCount = 0; //reset to show a new message in 60 frames
         }
@@ -19,6 +19,7 @@ class ParticleSystem;
 class AISystem;
 class CameraController;
 class ScriptSystem;
+class Scheduler;
 class ResourceManager;
 class Registry;
 namespace gsl {
@@ -70,6 +71,8 @@ private:
     cjk::Ref<CollisionSystem> mCollisionSystem;
     cjk::Ref<ScriptSystem> mScriptSystem;
     cjk::Ref<AISystem> mAISystem;
+    /// Runs the systems every frame, see init() for the order.
+    cjk::Scope<Scheduler> mScheduler;
 
     ResourceManager *mFactory;
     Registry *mRegistry;
@@ -81,6 +84,10 @@ private:
 
     //Input mInput;
 
+    static constexpr int MaxFrameRate{144};   //frames per second the render timer is capped at
+    static constexpr float TickRate{60.f};    //simulation ticks per second
+    static constexpr int MaxTicksPerFrame{5}; //ticks a slow frame may run to catch up, the rest is dropped
+
     QTimer *mRenderTimer{nullptr}; //timer that drives the gameloop
     QElapsedTimer mTimeStart;      //time variable that reads the actual FPS
     QElapsedTimer mTime;